@@ -0,0 +1,190 @@
+/**
+ * @file AABB.hpp
+ * @brief Axis-aligned bounding boxes and the tests we run on them.
+ * @author Michael Hitchens
+ */
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <limits>
+
+/**
+ * @brief An axis-aligned bounding box.
+ * @remark Same conventions as SceneNode: touching boxes do not overlap.
+ */
+struct AABB {
+    /** @brief The minimum corner. */
+    glm::vec3 min;
+    /** @brief The maximum corner. */
+    glm::vec3 max;
+
+    /** @brief Create an empty (inside out) box that anything can extend. */
+    AABB():
+        min( std::numeric_limits<float>::max() ),
+        max( -std::numeric_limits<float>::max() )
+    {
+    }
+
+    AABB( const glm::vec3 & bbMin, const glm::vec3 & bbMax ):
+        min( bbMin ),
+        max( bbMax )
+    {
+    }
+
+    /** @brief Grow to contain another box. */
+    void extend( const AABB & other )
+    {
+        min = glm::min( min, other.min );
+        max = glm::max( max, other.max );
+    }
+
+    /** @brief Grow to contain a point. */
+    void extend( const glm::vec3 & p )
+    {
+        min = glm::min( min, p );
+        max = glm::max( max, p );
+    }
+
+    glm::vec3 center() const
+    {
+        return 0.5f * ( min + max );
+    }
+
+    glm::vec3 halfExtents() const
+    {
+        return 0.5f * ( max - min );
+    }
+
+    /** @brief Surface area; the cost metric used for building hierarchies. */
+    float surfaceArea() const
+    {
+        glm::vec3 d = glm::max( max - min, glm::vec3( 0.f ) );
+        return 2.f * ( d.x * d.y + d.y * d.z + d.z * d.x );
+    }
+
+    /** @brief Strict overlap test; boxes that only touch don't overlap. */
+    bool overlaps( const AABB & o ) const
+    {
+        return min.x < o.max.x && min.y < o.max.y && min.z < o.max.z &&
+               o.min.x < max.x && o.min.y < max.y && o.min.z < max.z;
+    }
+
+    /** @brief Get the box moved by some amount. */
+    AABB translated( const glm::vec3 & delta ) const
+    {
+        return AABB( min + delta, max + delta );
+    }
+
+    /** @brief Get the box covering everywhere this box goes along a motion. */
+    AABB swept( const glm::vec3 & delta ) const
+    {
+        return AABB( glm::min( min, min + delta ), glm::max( max, max + delta ) );
+    }
+
+    /** @brief Get the box grown by some amount on every side. */
+    AABB expanded( const glm::vec3 & amount ) const
+    {
+        return AABB( min - amount, max + amount );
+    }
+};
+
+/**
+ * @brief A half-line with precomputed reciprocal direction.
+ */
+struct Ray {
+    glm::vec3 origin;
+    glm::vec3 direction;
+    glm::vec3 invDirection;
+
+    Ray( const glm::vec3 & o, const glm::vec3 & d ):
+        origin( o ),
+        direction( d ),
+        invDirection( 1.f / d.x, 1.f / d.y, 1.f / d.z )
+    {
+    }
+};
+
+/**
+ * @brief Intersect a ray with a box (slab method).
+ * @param ray The ray to cast.
+ * @param box The box to hit.
+ * @param maxT Ignore hits further along the ray than this.
+ * @param out_t Where the ray enters the box, in units of ray.direction.
+ * @param out_normal The face normal where the ray enters the box. Zero if the
+ *                   ray starts inside the box.
+ * @return true if the ray enters the box within [0, maxT].
+ * @remark Rays that only graze the surface, or that start touching the box and
+ *         move away from it, don't count as hits.
+ */
+inline bool
+intersectRayAABB( const Ray & ray,
+                  const AABB & box,
+                  float maxT,
+                  float & out_t,
+                  glm::vec3 & out_normal )
+{
+    float tEnter = -std::numeric_limits<float>::max();
+    float tExit = std::numeric_limits<float>::max();
+    int enterAxis = -1;
+
+    for ( int a = 0; a < 3; a++ ) {
+        if ( ray.direction[a] == 0.f ) {
+            // Parallel to the slab; we're either always in it or never
+            if ( ray.origin[a] <= box.min[a] || ray.origin[a] >= box.max[a] ) {
+                return false;
+            }
+            continue;
+        }
+
+        float t1 = ( box.min[a] - ray.origin[a] ) * ray.invDirection[a];
+        float t2 = ( box.max[a] - ray.origin[a] ) * ray.invDirection[a];
+        float tNear = std::min( t1, t2 );
+        float tFar = std::max( t1, t2 );
+
+        if ( tNear > tEnter ) {
+            tEnter = tNear;
+            enterAxis = a;
+        }
+        if ( tFar < tExit ) tExit = tFar;
+    }
+
+    if ( tEnter >= tExit || tExit <= 0.f || tEnter > maxT ) {
+        return false;
+    }
+
+    out_normal = glm::vec3( 0.f );
+    if ( tEnter < 0.f || enterAxis < 0 ) {
+        // Started inside
+        out_t = 0.f;
+    } else {
+        out_t = tEnter;
+        out_normal[enterAxis] = ray.direction[enterAxis] > 0.f ? -1.f : 1.f;
+    }
+    return true;
+}
+
+/**
+ * @brief Sweep one box along a path and find when it first hits another.
+ * @param moving The box at the start of the motion.
+ * @param delta The whole motion.
+ * @param target The box that might be hit.
+ * @param out_t Time of impact in [0, 1]; fraction of delta travelled.
+ * @param out_normal Normal of the target face that was hit; zero if the boxes
+ *                   already overlap at the start.
+ * @return true if the boxes collide during the motion.
+ * @remark Same as a ray from the moving box center against the target grown by
+ *         the moving box half extents (Minkowski sum).
+ */
+inline bool
+sweepAABB( const AABB & moving,
+           const glm::vec3 & delta,
+           const AABB & target,
+           float & out_t,
+           glm::vec3 & out_normal )
+{
+    Ray ray( moving.center(), delta );
+    return intersectRayAABB( ray, target.expanded( moving.halfExtents() ), 1.f, out_t, out_normal );
+}
@@ -0,0 +1,277 @@
+#include "AABBArray.hpp"
+
+#include <limits>
+
+#if defined(__AVX__)
+    #include <immintrin.h>
+    #define AABB_ARRAY_AVX
+#elif defined(__SSE__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 1 )
+    #include <xmmintrin.h>
+    #define AABB_ARRAY_SSE
+#endif
+
+/*******************************************************************************
+    KERNELS
+*******************************************************************************/
+
+// Each kernel tests a query against LANES boxes starting at index i and returns
+// a bit mask of the overlapping ones: bit k means box i + k overlaps. The tests
+// are the same strict comparisons as AABB::overlaps.
+
+#if defined(AABB_ARRAY_AVX)
+
+const int AABBArray::LANES = 8;
+
+/** @brief The query box broadcast to every lane. */
+struct QueryLanes {
+    __m256 minX, minY, minZ, maxX, maxY, maxZ;
+
+    explicit QueryLanes( const AABB & q ):
+        minX( _mm256_set1_ps( q.min.x ) ),
+        minY( _mm256_set1_ps( q.min.y ) ),
+        minZ( _mm256_set1_ps( q.min.z ) ),
+        maxX( _mm256_set1_ps( q.max.x ) ),
+        maxY( _mm256_set1_ps( q.max.y ) ),
+        maxZ( _mm256_set1_ps( q.max.z ) )
+    {
+    }
+};
+
+static inline unsigned
+overlapLanes( const QueryLanes & q,
+              const float * minX, const float * minY, const float * minZ,
+              const float * maxX, const float * maxY, const float * maxZ,
+              int i )
+{
+    __m256 r = _mm256_cmp_ps( _mm256_loadu_ps( minX + i ), q.maxX, _CMP_LT_OQ );
+    r = _mm256_and_ps( r, _mm256_cmp_ps( _mm256_loadu_ps( minY + i ), q.maxY, _CMP_LT_OQ ) );
+    r = _mm256_and_ps( r, _mm256_cmp_ps( _mm256_loadu_ps( minZ + i ), q.maxZ, _CMP_LT_OQ ) );
+    r = _mm256_and_ps( r, _mm256_cmp_ps( q.minX, _mm256_loadu_ps( maxX + i ), _CMP_LT_OQ ) );
+    r = _mm256_and_ps( r, _mm256_cmp_ps( q.minY, _mm256_loadu_ps( maxY + i ), _CMP_LT_OQ ) );
+    r = _mm256_and_ps( r, _mm256_cmp_ps( q.minZ, _mm256_loadu_ps( maxZ + i ), _CMP_LT_OQ ) );
+    return _mm256_movemask_ps( r );
+}
+
+#elif defined(AABB_ARRAY_SSE)
+
+const int AABBArray::LANES = 4;
+
+/** @brief The query box broadcast to every lane. */
+struct QueryLanes {
+    __m128 minX, minY, minZ, maxX, maxY, maxZ;
+
+    explicit QueryLanes( const AABB & q ):
+        minX( _mm_set1_ps( q.min.x ) ),
+        minY( _mm_set1_ps( q.min.y ) ),
+        minZ( _mm_set1_ps( q.min.z ) ),
+        maxX( _mm_set1_ps( q.max.x ) ),
+        maxY( _mm_set1_ps( q.max.y ) ),
+        maxZ( _mm_set1_ps( q.max.z ) )
+    {
+    }
+};
+
+static inline unsigned
+overlapLanes( const QueryLanes & q,
+              const float * minX, const float * minY, const float * minZ,
+              const float * maxX, const float * maxY, const float * maxZ,
+              int i )
+{
+    __m128 r = _mm_cmplt_ps( _mm_loadu_ps( minX + i ), q.maxX );
+    r = _mm_and_ps( r, _mm_cmplt_ps( _mm_loadu_ps( minY + i ), q.maxY ) );
+    r = _mm_and_ps( r, _mm_cmplt_ps( _mm_loadu_ps( minZ + i ), q.maxZ ) );
+    r = _mm_and_ps( r, _mm_cmplt_ps( q.minX, _mm_loadu_ps( maxX + i ) ) );
+    r = _mm_and_ps( r, _mm_cmplt_ps( q.minY, _mm_loadu_ps( maxY + i ) ) );
+    r = _mm_and_ps( r, _mm_cmplt_ps( q.minZ, _mm_loadu_ps( maxZ + i ) ) );
+    return _mm_movemask_ps( r );
+}
+
+#else
+
+const int AABBArray::LANES = 1;
+
+/** @brief The query box; nothing to broadcast without SIMD. */
+struct QueryLanes {
+    AABB box;
+
+    explicit QueryLanes( const AABB & q ):
+        box( q )
+    {
+    }
+};
+
+static inline unsigned
+overlapLanes( const QueryLanes & q,
+              const float * minX, const float * minY, const float * minZ,
+              const float * maxX, const float * maxY, const float * maxZ,
+              int i )
+{
+    return minX[i] < q.box.max.x && minY[i] < q.box.max.y && minZ[i] < q.box.max.z &&
+           q.box.min.x < maxX[i] && q.box.min.y < maxY[i] && q.box.min.z < maxZ[i];
+}
+
+#endif
+
+/** @brief Index of the lowest set bit; mask must not be 0. */
+static inline int
+lowestBit( unsigned mask )
+{
+    int bit = 0;
+    while ( !( mask & 1u ) ) {
+        mask >>= 1;
+        bit++;
+    }
+    return bit;
+}
+
+/*******************************************************************************
+    AABB ARRAY
+*******************************************************************************/
+
+AABBArray::AABBArray():
+    m_count( 0 ),
+    m_minX(),
+    m_minY(),
+    m_minZ(),
+    m_maxX(),
+    m_maxY(),
+    m_maxZ()
+{
+    reserve( 0 );
+}
+
+void
+AABBArray::clear()
+{
+    m_count = 0;
+    m_minX.clear();
+    m_minY.clear();
+    m_minZ.clear();
+    m_maxX.clear();
+    m_maxY.clear();
+    m_maxZ.clear();
+    reserve( 0 );
+}
+
+void
+AABBArray::reserve( int count )
+{
+    std::size_t needed = count + PADDING;
+    if ( m_minX.size() >= needed ) return;
+
+    // Unused slots hold an inside out box which fails every comparison
+    const float big = std::numeric_limits<float>::max();
+    m_minX.resize( needed, big );
+    m_minY.resize( needed, big );
+    m_minZ.resize( needed, big );
+    m_maxX.resize( needed, -big );
+    m_maxY.resize( needed, -big );
+    m_maxZ.resize( needed, -big );
+}
+
+int
+AABBArray::add( const AABB & box )
+{
+    if ( m_minX.size() < (std::size_t)( m_count + 1 + PADDING ) ) {
+        reserve( 2 * m_count + 1 );
+    }
+
+    set( m_count, box );
+    return m_count++;
+}
+
+void
+AABBArray::set( int i,
+                const AABB & box )
+{
+    m_minX[i] = box.min.x;
+    m_minY[i] = box.min.y;
+    m_minZ[i] = box.min.z;
+    m_maxX[i] = box.max.x;
+    m_maxY[i] = box.max.y;
+    m_maxZ[i] = box.max.z;
+}
+
+AABB
+AABBArray::get( int i )
+const {
+    return AABB( glm::vec3( m_minX[i], m_minY[i], m_minZ[i] ),
+                 glm::vec3( m_maxX[i], m_maxY[i], m_maxZ[i] ) );
+}
+
+int
+AABBArray::size()
+const {
+    return m_count;
+}
+
+int
+AABBArray::findFirstOverlap( const AABB & query,
+                             int begin,
+                             int end )
+const {
+    QueryLanes q( query );
+
+    for ( int i = begin; i < end; i += LANES ) {
+        unsigned mask = overlapLanes( q, &m_minX[0], &m_minY[0], &m_minZ[0], &m_maxX[0], &m_maxY[0], &m_maxZ[0], i );
+
+        // The last chunk can run past end into boxes we weren't asked about
+        if ( end - i < LANES ) mask &= ( 1u << ( end - i ) ) - 1u;
+
+        if ( mask ) return i + lowestBit( mask );
+    }
+
+    return -1;
+}
+
+int
+AABBArray::findFirstOverlap( const AABB & query )
+const {
+    return findFirstOverlap( query, 0, m_count );
+}
+
+void
+AABBArray::findOverlaps( const AABB & query,
+                         std::vector<int> & out )
+const {
+    findOverlaps( query, 0, m_count, out );
+}
+
+void
+AABBArray::findOverlaps( const AABB & query,
+                         int begin,
+                         int end,
+                         std::vector<int> & out )
+const {
+    QueryLanes q( query );
+
+    for ( int i = begin; i < end; i += LANES ) {
+        unsigned mask = overlapLanes( q, &m_minX[0], &m_minY[0], &m_minZ[0], &m_maxX[0], &m_maxY[0], &m_maxZ[0], i );
+        if ( end - i < LANES ) mask &= ( 1u << ( end - i ) ) - 1u;
+
+        while ( mask ) {
+            out.push_back( i + lowestBit( mask ) );
+            mask &= mask - 1u;
+        }
+    }
+}
+
+void
+AABBArray::findOverlapsMany( const std::vector<AABB> & queries,
+                             std::vector<int> & out_query,
+                             std::vector<int> & out_box )
+const {
+    for ( std::size_t qi = 0; qi < queries.size(); qi++ ) {
+        QueryLanes q( queries[qi] );
+
+        // Padding never overlaps so the last chunk can run past m_count
+        for ( int i = 0; i < m_count; i += LANES ) {
+            unsigned mask = overlapLanes( q, &m_minX[0], &m_minY[0], &m_minZ[0], &m_maxX[0], &m_maxY[0], &m_maxZ[0], i );
+            while ( mask ) {
+                out_query.push_back( qi );
+                out_box.push_back( i + lowestBit( mask ) );
+                mask &= mask - 1u;
+            }
+        }
+    }
+}
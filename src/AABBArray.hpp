@@ -0,0 +1,92 @@
+/**
+ * @file AABBArray.hpp
+ * @brief Interface for AABBArray
+ * @author Michael Hitchens
+ */
+
+#pragma once
+
+#include "AABB.hpp"
+
+#include <vector>
+
+/**
+ * @brief Many boxes stored as separate min/max arrays (structure of arrays).
+ * @details Laying the boxes out this way lets one query be tested against 8
+ *          (AVX) or 4 (SSE) boxes per instruction. Builds without either fall
+ *          back to plain scalar code with the same results.
+ * @remark Arrays are padded with empty boxes so the vector loops never need a
+ *         scalar tail; padding never overlaps anything.
+ */
+class AABBArray {
+public:
+    /** @brief Number of boxes tested per instruction in this build. */
+    const static int LANES;
+
+    AABBArray();
+
+    /** @brief Remove all boxes. */
+    void clear();
+
+    /** @brief Make room for a number of boxes. */
+    void reserve( int count );
+
+    /**
+     * @brief Append a box.
+     * @return The index of the new box.
+     */
+    int add( const AABB & box );
+
+    /** @brief Replace the box at an index. */
+    void set( int i, const AABB & box );
+
+    /** @brief Get the box at an index. */
+    AABB get( int i ) const;
+
+    /** @brief Get the number of boxes. */
+    int size() const;
+
+    /**
+     * @brief Find the first box overlapping the query.
+     * @param query The box to test.
+     * @param begin First index to consider.
+     * @param end One past the last index to consider.
+     * @return The smallest overlapping index in [begin, end), or -1.
+     */
+    int findFirstOverlap( const AABB & query, int begin, int end ) const;
+
+    /** @brief Find the first box overlapping the query, or -1. */
+    int findFirstOverlap( const AABB & query ) const;
+
+    /**
+     * @brief Find every box overlapping the query.
+     * @param query The box to test.
+     * @param out Where to append overlapping indices, in increasing order.
+     */
+    void findOverlaps( const AABB & query, std::vector<int> & out ) const;
+
+    /** @brief Find every box in [begin, end) overlapping the query. */
+    void findOverlaps( const AABB & query, int begin, int end, std::vector<int> & out ) const;
+
+    /**
+     * @brief Test many queries against every box.
+     * @param queries The boxes to test.
+     * @param out_query Where to append the query index of each overlap.
+     * @param out_box Where to append the box index of each overlap.
+     * @remark Results are grouped by query in increasing order, then by box.
+     */
+    void findOverlapsMany( const std::vector<AABB> & queries, std::vector<int> & out_query, std::vector<int> & out_box ) const;
+
+private:
+    /** @brief Padding kept past the last box; at least the widest LANES. */
+    const static int PADDING = 8;
+
+    /** @brief Number of real boxes; the arrays are longer. */
+    int m_count;
+    std::vector<float> m_minX;
+    std::vector<float> m_minY;
+    std::vector<float> m_minZ;
+    std::vector<float> m_maxX;
+    std::vector<float> m_maxY;
+    std::vector<float> m_maxZ;
+};
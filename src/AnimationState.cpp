@@ -0,0 +1,50 @@
+#include "AnimationState.hpp"
+
+#include "Model.hpp"
+
+void
+startAnimation( AnimationState & anim,
+                const Model * model )
+{
+    anim.keyframe = 0;
+    anim.frameCount = 0;
+    anim.frameLength = model->getFrameLength( 0 );
+}
+
+void
+stepAnimation( AnimationState & anim,
+               const Model * model )
+{
+    if ( !model->isAnimated() ) return;
+
+    anim.frameCount++;
+    if ( anim.frameCount >= anim.frameLength ) {
+        anim.frameCount = 0;
+        anim.keyframe++;
+        anim.frameLength = model->getFrameLength( anim.keyframe );
+    }
+}
+
+void
+sampleAnimation( const AnimationState & anim,
+                 const Model * model,
+                 float interpolation,
+                 int & out_keyframe,
+                 float & out_blend )
+{
+    int keyframe = anim.keyframe;
+    float length = anim.frameLength;
+    float frame = anim.frameCount - 1 + interpolation;
+    if ( frame < 0.f ) {
+        if ( keyframe > 0 ) {
+            keyframe--;
+            length = model->getFrameLength( keyframe );
+            frame += length;
+        } else {
+            frame = 0.f;
+        }
+    }
+
+    out_keyframe = keyframe;
+    out_blend = frame / length;
+}
@@ -0,0 +1,43 @@
+/**
+ * @file AnimationState.hpp
+ * @brief Interface for AnimationState
+ * @author Michael Hitchens
+ */
+
+#pragma once
+
+// forward decls
+class Model;
+
+/**
+ * @brief How far a model has played through its keyframes.
+ * @remark Plain data so level scenery and entities can both carry one; the
+ *         model it belongs to is passed in alongside.
+ */
+struct AnimationState {
+    /** @brief The current keyframe to draw. */
+    int keyframe;
+    /** @brief How long the keyframe has been shown. */
+    int frameCount;
+    /** @brief The current keyframe length. */
+    int frameLength;
+};
+
+/** @brief Start from the first keyframe of a model. */
+void startAnimation( AnimationState & anim, const Model * model );
+
+/**
+ * @brief Play one update's worth of animation.
+ * @remark Does nothing for models with only one keyframe.
+ */
+void stepAnimation( AnimationState & anim, const Model * model );
+
+/**
+ * @brief Get what to draw between the last two updates.
+ * @param interpolation How far between the last two updates, in [0, 1].
+ * @param out_keyframe The keyframe to draw.
+ * @param out_blend How far to blend towards the keyframe after it.
+ * @remark The animation was one frame behind where it is now, which may have
+ *         been the end of the previous keyframe.
+ */
+void sampleAnimation( const AnimationState & anim, const Model * model, float interpolation, int & out_keyframe, float & out_blend );
@@ -0,0 +1,86 @@
+#include "Arena.hpp"
+
+#include <cstdint>
+
+const std::size_t Arena::DEFAULT_BLOCK_SIZE = 256 * 1024;
+
+Arena::Arena( std::size_t blockSize ):
+    m_blocks(),
+    m_finalizers(),
+    m_blockSize( blockSize ),
+    m_bytesUsed( 0 )
+{
+    // nothing else to do
+}
+
+Arena::~Arena()
+{
+    runFinalizers();
+    for ( Block & b : m_blocks ) {
+        delete [] b.data;
+    }
+}
+
+void *
+Arena::allocate( std::size_t size,
+                 std::size_t alignment )
+{
+    if ( !m_blocks.empty() ) {
+        Block & b = m_blocks.back();
+        std::uintptr_t base = reinterpret_cast<std::uintptr_t>( b.data );
+        std::uintptr_t aligned = ( base + b.used + alignment - 1 ) & ~( alignment - 1 );
+        std::size_t offset = aligned - base;
+        if ( offset + size <= b.size ) {
+            b.used = offset + size;
+            m_bytesUsed += size;
+            return b.data + offset;
+        }
+    }
+
+    // Doesn't fit; grab a new block big enough for this allocation. new[] is
+    // aligned for any fundamental type so offset 0 is always good enough.
+    std::size_t blockSize = m_blockSize;
+    if ( size + alignment > blockSize ) blockSize = size + alignment;
+
+    Block b = { new char[blockSize], blockSize, 0 };
+    m_blocks.push_back( b );
+
+    return allocate( size, alignment );
+}
+
+void
+Arena::reset()
+{
+    runFinalizers();
+
+    // Keep the first block so the next level built doesn't hit the heap again.
+    for ( std::size_t i = 1; i < m_blocks.size(); i++ ) {
+        delete [] m_blocks[i].data;
+    }
+    if ( !m_blocks.empty() ) {
+        m_blocks.resize( 1 );
+        m_blocks[0].used = 0;
+    }
+    m_bytesUsed = 0;
+}
+
+std::size_t
+Arena::getBytesUsed()
+const {
+    return m_bytesUsed;
+}
+
+std::size_t
+Arena::getBlockCount()
+const {
+    return m_blocks.size();
+}
+
+void
+Arena::runFinalizers()
+{
+    for ( auto it = m_finalizers.rbegin(); it != m_finalizers.rend(); ++it ) {
+        it->fn( it->obj );
+    }
+    m_finalizers.clear();
+}
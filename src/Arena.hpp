@@ -0,0 +1,112 @@
+/**
+ * @file Arena.hpp
+ * @brief Interface for Arena
+ * @author Michael Hitchens
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief A bump allocator that owns everything allocated from it.
+ * @details Memory is carved out of a few large blocks. Nothing is freed
+ *          individually; everything goes away at once when the arena is reset
+ *          or destroyed.
+ * @remark Objects made with make() that have non-trivial destructors get their
+ *         destructor called on reset, newest first. Trivially destructible
+ *         objects cost nothing to release.
+ * @remark Objects in the arena must NEVER be deleted!
+ */
+class Arena {
+public:
+    /** @brief Size of each block unless a bigger one is needed. */
+    const static std::size_t DEFAULT_BLOCK_SIZE;
+
+    /**
+     * @brief Create an empty arena.
+     * @param blockSize Size of each block we grab from the heap.
+     * @remark No memory is allocated until the first allocation.
+     */
+    explicit Arena( std::size_t blockSize = DEFAULT_BLOCK_SIZE );
+
+    /** @brief Destroy all objects and release all blocks. */
+    ~Arena();
+
+    /**
+     * @brief Get raw memory from the arena.
+     * @param size Number of bytes needed.
+     * @param alignment Required alignment; must be a power of 2.
+     * @return Memory that lives until the arena is reset.
+     */
+    void * allocate( std::size_t size, std::size_t alignment );
+
+    /**
+     * @brief Construct an object in the arena.
+     * @param args Constructor arguments.
+     * @return The new object; owned by the arena.
+     */
+    template <typename T, typename... Args>
+    T * make( Args&&... args )
+    {
+        void * mem = allocate( sizeof(T), alignof(T) );
+        T * obj = new (mem) T( std::forward<Args>(args)... );
+        if ( !std::is_trivially_destructible<T>::value ) {
+            Finalizer fin = { &Arena::destroy<T>, obj };
+            m_finalizers.push_back( fin );
+        }
+        return obj;
+    }
+
+    /**
+     * @brief Destroy all objects and forget all allocations.
+     * @remark The first block is kept around so rebuilding is cheap.
+     */
+    void reset();
+
+    /** @brief Get the number of bytes handed out so far. */
+    std::size_t getBytesUsed() const;
+
+    /** @brief Get the number of blocks grabbed from the heap. */
+    std::size_t getBlockCount() const;
+
+private:
+    /** @brief A contiguous chunk of memory we bump allocate from. */
+    struct Block {
+        char * data;
+        std::size_t size;
+        std::size_t used;
+    };
+
+    /** @brief A destructor to run on reset. */
+    struct Finalizer {
+        void (*fn)( void * );
+        void * obj;
+    };
+
+    template <typename T>
+    static void destroy( void * obj )
+    {
+        static_cast<T *>( obj )->~T();
+    }
+
+    // No copying; we own raw memory.
+    Arena( const Arena & );
+    Arena & operator=( const Arena & );
+
+    /** @brief Run all finalizers, newest first. */
+    void runFinalizers();
+
+    /** @brief Blocks grabbed so far; the last one is being filled. */
+    std::vector<Block> m_blocks;
+    /** @brief Destructors to call on reset. */
+    std::vector<Finalizer> m_finalizers;
+    /** @brief Size of newly grabbed blocks. */
+    std::size_t m_blockSize;
+    /** @brief Total bytes handed out. */
+    std::size_t m_bytesUsed;
+};
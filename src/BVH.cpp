@@ -0,0 +1,417 @@
+#include "BVH.hpp"
+
+#include <algorithm>
+
+const int BVH::MAX_LEAF_SIZE = 4;
+const int BVH::BIN_COUNT = 12;
+const int BVH::MAX_SAH_DEPTH = 32;
+
+BVH::BVH():
+    m_nodes(),
+    m_items(),
+    m_leafBoxes()
+{
+    // nothing else to do
+}
+
+void
+BVH::build( const std::vector<AABB> & boxes )
+{
+    clear();
+    if ( boxes.empty() ) return;
+
+    m_items.reserve( boxes.size() );
+    for ( std::size_t i = 0; i < boxes.size(); i++ ) {
+        Item item = { boxes[i], (int)i };
+        m_items.push_back( item );
+    }
+
+    // A binary tree with n leaves has 2n - 1 nodes at most
+    m_nodes.reserve( 2 * boxes.size() );
+    buildNode( 0, m_items.size(), 0 );
+
+    // Building shuffled the items into leaf order; copy them only now
+    m_leafBoxes.reserve( m_items.size() );
+    for ( const Item & item : m_items ) {
+        m_leafBoxes.add( item.box );
+    }
+}
+
+void
+BVH::clear()
+{
+    m_nodes.clear();
+    m_items.clear();
+    m_leafBoxes.clear();
+}
+
+bool
+BVH::empty()
+const {
+    return m_nodes.empty();
+}
+
+int
+BVH::getNodeCount()
+const {
+    return m_nodes.size();
+}
+
+AABB
+BVH::getBounds()
+const {
+    return m_nodes.empty() ? AABB() : m_nodes[0].bounds;
+}
+
+int
+BVH::buildNode( int first,
+                int count,
+                int depth )
+{
+    int index = m_nodes.size();
+    m_nodes.push_back( Node() );
+
+    AABB bounds;
+    AABB centroids;
+    for ( int i = first; i < first + count; i++ ) {
+        bounds.extend( m_items[i].box );
+        centroids.extend( m_items[i].box.center() );
+    }
+    m_nodes[index].bounds = bounds;
+    m_nodes[index].offset = first;
+    m_nodes[index].count = count;
+
+    if ( count <= MAX_LEAF_SIZE ) return index;
+
+    // Split along the axis where the centers are most spread out
+    glm::vec3 extent = centroids.max - centroids.min;
+    int axis = 0;
+    if ( extent.y > extent[axis] ) axis = 1;
+    if ( extent.z > extent[axis] ) axis = 2;
+
+    // Everything is stacked on the same spot; no split will help
+    if ( extent[axis] <= 0.f ) return index;
+
+    // Bin the boxes by center then evaluate the SAH cost of splitting after
+    // each bin: area(left) * count(left) + area(right) * count(right)
+    std::vector<AABB> binBounds( BIN_COUNT );
+    std::vector<int> binCounts( BIN_COUNT, 0 );
+    float scale = BIN_COUNT / extent[axis];
+    for ( int i = first; i < first + count; i++ ) {
+        int b = (int)( ( m_items[i].box.center()[axis] - centroids.min[axis] ) * scale );
+        if ( b >= BIN_COUNT ) b = BIN_COUNT - 1;
+        binCounts[b]++;
+        binBounds[b].extend( m_items[i].box );
+    }
+
+    std::vector<float> leftCost( BIN_COUNT, 0.f );
+    AABB acc;
+    int accCount = 0;
+    for ( int b = 0; b < BIN_COUNT - 1; b++ ) {
+        acc.extend( binBounds[b] );
+        accCount += binCounts[b];
+        leftCost[b] = accCount ? acc.surfaceArea() * accCount : 0.f;
+    }
+
+    float bestCost = std::numeric_limits<float>::max();
+    int bestSplit = -1;
+    acc = AABB();
+    accCount = 0;
+    for ( int b = BIN_COUNT - 1; b > 0; b-- ) {
+        acc.extend( binBounds[b] );
+        accCount += binCounts[b];
+        float cost = leftCost[b-1] + ( accCount ? acc.surfaceArea() * accCount : 0.f );
+        if ( cost < bestCost ) {
+            bestCost = cost;
+            bestSplit = b;
+        }
+    }
+
+    Item * begin = &m_items[first];
+    Item * end = begin + count;
+    Item * mid = begin;
+    if ( depth < MAX_SAH_DEPTH ) {
+        mid = std::partition( begin, end, [&]( const Item & item ) {
+            int b = (int)( ( item.box.center()[axis] - centroids.min[axis] ) * scale );
+            if ( b >= BIN_COUNT ) b = BIN_COUNT - 1;
+            return b < bestSplit;
+        });
+    }
+
+    // Binning can fail to separate clustered boxes, and lopsided splits can
+    // make the tree too deep; fall back to the median in both cases.
+    if ( mid == begin || mid == end ) {
+        mid = begin + count / 2;
+        std::nth_element( begin, mid, end, [&]( const Item & a, const Item & b ) {
+            return a.box.center()[axis] < b.box.center()[axis];
+        });
+    }
+
+    int leftCount = mid - begin;
+    m_nodes[index].count = 0;
+    buildNode( first, leftCount, depth + 1 ); // always index + 1
+    int right = buildNode( first + leftCount, count - leftCount, depth + 1 );
+    m_nodes[index].offset = right;
+
+    return index;
+}
+
+int
+BVH::findOverlap( const AABB & query )
+const {
+    if ( m_nodes.empty() ) return -1;
+
+    int stack[STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+
+    while ( top > 0 ) {
+        const Node & node = m_nodes[stack[--top]];
+        if ( !node.bounds.overlaps( query ) ) continue;
+
+        if ( node.count > 0 ) {
+            int i = m_leafBoxes.findFirstOverlap( query, node.offset, node.offset + node.count );
+            if ( i >= 0 ) return m_items[i].index;
+        } else {
+            stack[top++] = node.offset;
+            stack[top++] = &node - &m_nodes[0] + 1;
+        }
+    }
+
+    return -1;
+}
+
+void
+BVH::findOverlaps( const AABB & query,
+                   std::vector<int> & out )
+const {
+    if ( m_nodes.empty() ) return;
+
+    std::vector<int> leafHits;
+    int stack[STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+
+    while ( top > 0 ) {
+        const Node & node = m_nodes[stack[--top]];
+        if ( !node.bounds.overlaps( query ) ) continue;
+
+        if ( node.count > 0 ) {
+            leafHits.clear();
+            m_leafBoxes.findOverlaps( query, node.offset, node.offset + node.count, leafHits );
+            for ( int i : leafHits ) {
+                out.push_back( m_items[i].index );
+            }
+        } else {
+            stack[top++] = node.offset;
+            stack[top++] = &node - &m_nodes[0] + 1;
+        }
+    }
+}
+
+void
+BVH::findOverlapsMany( const std::vector<AABB> & queries,
+                       std::vector<BVHPair> & out )
+const {
+    if ( m_nodes.empty() || queries.empty() ) return;
+
+    // active holds a stack of query lists, one per level of the traversal
+    std::vector<int> active;
+    active.reserve( queries.size() * 4 );
+    for ( std::size_t i = 0; i < queries.size(); i++ ) {
+        active.push_back( i );
+    }
+
+    overlapsMany( 0, queries, active, 0, queries.size(), out );
+}
+
+void
+BVH::overlapsMany( int nodeIndex,
+                   const std::vector<AABB> & queries,
+                   std::vector<int> & active,
+                   std::size_t begin,
+                   std::size_t end,
+                   std::vector<BVHPair> & out )
+const {
+    const Node & node = m_nodes[nodeIndex];
+
+    // Narrow the parent's list down to the queries that touch this node
+    std::size_t myBegin = active.size();
+    for ( std::size_t i = begin; i < end; i++ ) {
+        int q = active[i];
+        if ( queries[q].overlaps( node.bounds ) ) active.push_back( q );
+    }
+    std::size_t myEnd = active.size();
+
+    if ( myBegin != myEnd ) {
+        if ( node.count > 0 ) {
+            std::vector<int> leafHits;
+            for ( std::size_t j = myBegin; j < myEnd; j++ ) {
+                leafHits.clear();
+                m_leafBoxes.findOverlaps( queries[active[j]], node.offset, node.offset + node.count, leafHits );
+                for ( int i : leafHits ) {
+                    BVHPair pair = { active[j], m_items[i].index };
+                    out.push_back( pair );
+                }
+            }
+        } else {
+            overlapsMany( nodeIndex + 1, queries, active, myBegin, myEnd, out );
+            overlapsMany( node.offset, queries, active, myBegin, myEnd, out );
+        }
+    }
+
+    active.resize( myBegin );
+}
+
+bool
+BVH::raycast( const Ray & ray,
+              float maxT,
+              BVHHit & out_hit )
+const {
+    return castExpanded( ray, glm::vec3( 0.f ), maxT, out_hit );
+}
+
+void
+BVH::raycastMany( const std::vector<Ray> & rays,
+                  float maxT,
+                  std::vector<BVHHit> & out_hits )
+const {
+    BVHHit none = { -1, maxT, glm::vec3( 0.f ) };
+    out_hits.assign( rays.size(), none );
+    if ( m_nodes.empty() || rays.empty() ) return;
+
+    // Same stack of lists as findOverlapsMany, one per level of the traversal
+    std::vector<int> active;
+    active.reserve( rays.size() * 4 );
+    for ( std::size_t i = 0; i < rays.size(); i++ ) {
+        active.push_back( i );
+    }
+
+    castMany( 0, rays, active, 0, rays.size(), out_hits );
+}
+
+void
+BVH::castMany( int nodeIndex,
+               const std::vector<Ray> & rays,
+               std::vector<int> & active,
+               std::size_t begin,
+               std::size_t end,
+               std::vector<BVHHit> & hits )
+const {
+    const Node & node = m_nodes[nodeIndex];
+
+    // Narrow the parent's list down to the rays that reach this node before
+    // their closest hit so far
+    std::size_t myBegin = active.size();
+    for ( std::size_t i = begin; i < end; i++ ) {
+        int r = active[i];
+        float t;
+        glm::vec3 normal;
+        if ( intersectRayAABB( rays[r], node.bounds, hits[r].t, t, normal ) ) active.push_back( r );
+    }
+    std::size_t myEnd = active.size();
+
+    if ( myBegin != myEnd ) {
+        if ( node.count > 0 ) {
+            for ( std::size_t j = myBegin; j < myEnd; j++ ) {
+                int r = active[j];
+                for ( int i = node.offset; i < node.offset + node.count; i++ ) {
+                    float t;
+                    glm::vec3 normal;
+                    if ( !intersectRayAABB( rays[r], m_items[i].box, hits[r].t, t, normal ) ) continue;
+
+                    if ( hits[r].item < 0 || t < hits[r].t || ( t == hits[r].t && m_items[i].index < hits[r].item ) ) {
+                        hits[r].item = m_items[i].index;
+                        hits[r].t = t;
+                        hits[r].normal = normal;
+                    }
+                }
+            }
+        } else {
+            // Near side first, judged by where the rays are heading on the
+            // whole, so the far side is more often skipped
+            glm::vec3 heading( 0.f );
+            for ( std::size_t j = myBegin; j < myEnd; j++ ) {
+                heading += rays[active[j]].direction;
+            }
+            int left = nodeIndex + 1;
+            int right = node.offset;
+            if ( glm::dot( m_nodes[right].bounds.center() - m_nodes[left].bounds.center(), heading ) >= 0.f ) {
+                castMany( left, rays, active, myBegin, myEnd, hits );
+                castMany( right, rays, active, myBegin, myEnd, hits );
+            } else {
+                castMany( right, rays, active, myBegin, myEnd, hits );
+                castMany( left, rays, active, myBegin, myEnd, hits );
+            }
+        }
+    }
+
+    active.resize( myBegin );
+}
+
+bool
+BVH::sweep( const AABB & moving,
+            const glm::vec3 & delta,
+            BVHHit & out_hit )
+const {
+    // Sweeping a box is casting its center against everything grown by its
+    // half extents.
+    Ray ray( moving.center(), delta );
+    return castExpanded( ray, moving.halfExtents(), 1.f, out_hit );
+}
+
+bool
+BVH::castExpanded( const Ray & ray,
+                   const glm::vec3 & expand,
+                   float maxT,
+                   BVHHit & out_hit )
+const {
+    if ( m_nodes.empty() ) return false;
+
+    bool found = false;
+    float closest = maxT;
+
+    int stack[STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+
+    while ( top > 0 ) {
+        const Node & node = m_nodes[stack[--top]];
+
+        float t;
+        glm::vec3 normal;
+        if ( !intersectRayAABB( ray, node.bounds.expanded( expand ), closest, t, normal ) ) continue;
+
+        if ( node.count > 0 ) {
+            for ( int i = node.offset; i < node.offset + node.count; i++ ) {
+                if ( intersectRayAABB( ray, m_items[i].box.expanded( expand ), closest, t, normal ) ) {
+                    // Ties go to the lower index so the answer doesn't
+                    // depend on the order nodes are visited in
+                    if ( !found || t < closest || ( t == closest && m_items[i].index < out_hit.item ) ) {
+                        closest = t;
+                        out_hit.item = m_items[i].index;
+                        out_hit.t = t;
+                        out_hit.normal = normal;
+                        found = true;
+                    }
+                }
+            }
+        } else {
+            // Visit the child on the near side of the ray first; it's pushed
+            // last so it's popped first.
+            int left = &node - &m_nodes[0] + 1;
+            int right = node.offset;
+            glm::vec3 toLeft = m_nodes[left].bounds.center() - ray.origin;
+            glm::vec3 toRight = m_nodes[right].bounds.center() - ray.origin;
+            if ( glm::dot( toLeft, ray.direction ) < glm::dot( toRight, ray.direction ) ) {
+                stack[top++] = right;
+                stack[top++] = left;
+            } else {
+                stack[top++] = left;
+                stack[top++] = right;
+            }
+        }
+    }
+
+    return found;
+}
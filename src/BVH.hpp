@@ -0,0 +1,171 @@
+/**
+ * @file BVH.hpp
+ * @brief Interface for BVH
+ * @author Michael Hitchens
+ */
+
+#pragma once
+
+#include "AABB.hpp"
+#include "AABBArray.hpp"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+/**
+ * @brief Result of a ray or sweep query against a BVH.
+ */
+struct BVHHit {
+    /** @brief Index of the box that was hit, as given to build(). */
+    int item;
+    /** @brief Ray distance or sweep fraction where the hit happened. */
+    float t;
+    /** @brief Face normal of the box that was hit. */
+    glm::vec3 normal;
+};
+
+/**
+ * @brief A pair of overlapping boxes from a batched query.
+ */
+struct BVHPair {
+    /** @brief Index into the query list. */
+    int query;
+    /** @brief Index of the box that was hit, as given to build(). */
+    int item;
+};
+
+/**
+ * @brief Bounding volume hierarchy over a fixed set of boxes.
+ * @details Built top-down with binned surface area heuristic (SAH) splits.
+ *          Nodes are stored depth first in one flat array: the left child of a
+ *          node is always the next node in the array.
+ * @remark Meant for things that don't move. Rebuild if the boxes change.
+ */
+class BVH {
+public:
+    BVH();
+
+    /**
+     * @brief Build the hierarchy.
+     * @param boxes The boxes to put in the hierarchy. Queries report hits by
+     *              index into this list.
+     */
+    void build( const std::vector<AABB> & boxes );
+
+    /** @brief Forget all boxes. */
+    void clear();
+
+    /** @brief Get whether there's nothing in the hierarchy. */
+    bool empty() const;
+
+    /** @brief Get the number of nodes in the flat node array. */
+    int getNodeCount() const;
+
+    /** @brief Get the box that contains every box in the hierarchy. */
+    AABB getBounds() const;
+
+    /**
+     * @brief Find any box overlapping the query.
+     * @param query The box to test.
+     * @return Index of an overlapping box or -1 if none.
+     */
+    int findOverlap( const AABB & query ) const;
+
+    /**
+     * @brief Find all boxes overlapping the query.
+     * @param query The box to test.
+     * @param out Where to append indices of overlapping boxes.
+     */
+    void findOverlaps( const AABB & query, std::vector<int> & out ) const;
+
+    /**
+     * @brief Find all overlaps for many queries in one traversal.
+     * @param queries The boxes to test.
+     * @param out Where to append every (query, box) pair that overlaps.
+     * @remark Each node is visited at most once no matter how many queries
+     *         there are; only the queries touching a node are carried into it.
+     */
+    void findOverlapsMany( const std::vector<AABB> & queries, std::vector<BVHPair> & out ) const;
+
+    /**
+     * @brief Find the closest box along a ray.
+     * @param ray The ray to cast.
+     * @param maxT Ignore hits further than this along the ray.
+     * @param out_hit Where to store the closest hit.
+     * @return true if something was hit.
+     */
+    bool raycast( const Ray & ray, float maxT, BVHHit & out_hit ) const;
+
+    /**
+     * @brief Find the closest box along many rays in one traversal.
+     * @param rays The rays to cast.
+     * @param maxT Ignore hits further than this along any ray.
+     * @param out_hits Replaced with one result per ray; item is -1 for rays
+     *                 that hit nothing.
+     * @remark Same answers as raycast() one ray at a time. Each node is
+     *         visited at most once; only the rays that can still reach it
+     *         are carried into it, so rays that start near each other and go
+     *         roughly the same way share most of the work.
+     */
+    void raycastMany( const std::vector<Ray> & rays, float maxT, std::vector<BVHHit> & out_hits ) const;
+
+    /**
+     * @brief Find the first box hit by a box moving along a path.
+     * @param moving The box at the start of the motion.
+     * @param delta The whole motion.
+     * @param out_hit Where to store the first hit; t is in [0, 1].
+     * @return true if something was hit.
+     */
+    bool sweep( const AABB & moving, const glm::vec3 & delta, BVHHit & out_hit ) const;
+
+private:
+    /** @brief Number of boxes in a leaf before we consider splitting. */
+    const static int MAX_LEAF_SIZE;
+    /** @brief Number of buckets used to evaluate SAH splits. */
+    const static int BIN_COUNT;
+    /** @brief Depth after which we split at the median to bound tree height. */
+    const static int MAX_SAH_DEPTH;
+    /** @brief Size of the traversal stacks; must exceed the tree height. */
+    const static int STACK_SIZE = 64;
+
+    /**
+     * @brief A node in the flat array.
+     * @remark Leaves have count > 0 and their boxes are m_items[offset,
+     *         offset + count). Inner nodes have count == 0; their left child
+     *         is the next node and their right child is at offset.
+     */
+    struct Node {
+        AABB bounds;
+        int offset;
+        int count;
+    };
+
+    /** @brief A box plus the index it was given to us with. */
+    struct Item {
+        AABB box;
+        int index;
+    };
+
+    /**
+     * @brief Build the subtree for m_items[first, first + count).
+     * @param depth How deep the new node is in the tree.
+     * @return The index of the new node.
+     */
+    int buildNode( int first, int count, int depth );
+
+    /** @brief Closest hit of a ray against boxes grown by some amount. */
+    bool castExpanded( const Ray & ray, const glm::vec3 & expand, float maxT, BVHHit & out_hit ) const;
+
+    /** @brief Recursive part of raycastMany. */
+    void castMany( int node, const std::vector<Ray> & rays, std::vector<int> & active, std::size_t begin, std::size_t end, std::vector<BVHHit> & hits ) const;
+
+    /** @brief Recursive part of findOverlapsMany. */
+    void overlapsMany( int node, const std::vector<AABB> & queries, std::vector<int> & active, std::size_t begin, std::size_t end, std::vector<BVHPair> & out ) const;
+
+    /** @brief All nodes; the root is at index 0. */
+    std::vector<Node> m_nodes;
+    /** @brief All boxes, reordered so that each leaf is a contiguous range. */
+    std::vector<Item> m_items;
+    /** @brief The boxes of m_items again, laid out for the SIMD leaf tests. */
+    AABBArray m_leafBoxes;
+};
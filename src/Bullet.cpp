@@ -1,34 +1,34 @@
 #include "Bullet.hpp"
 
-#include "Material.hpp"
-#include "Shader.hpp"
 #include "Model.hpp"
+#include "SceneNode.hpp"
+#include "World.hpp"
 
 const glm::vec3 Bullet::MODEL_SCALE = glm::vec3( 0.25f, 0.25f, 0.25f );
+const int Bullet::LIFE = 300; // arbitrary
 
-Bullet::Bullet( Model * prim,
+Entity
+Bullet::create( World & world,
+                Model * prim,
                 Material * mat,
-                Shader * shader,
                 const glm::vec3 & position,
-                const glm::vec3 & velocity ):
-    GeometryNode( prim, mat, shader ),
-    m_velocity(velocity),
-    m_life(300) // arbitrary
+                const glm::vec3 & velocity )
 {
-    scale( MODEL_SCALE );
-    translate( position );
-}
+    glm::vec3 bbMin, bbMax;
+    prim->getBoundingBox( bbMin, bbMax );
 
-void
-Bullet::update()
-{
-    translate( m_velocity );
-    m_life--;
-    // TODO chekc for collisions
+    Entity e = world.create();
+    Transform transform = { position, MODEL_SCALE, position };
+    Velocity motion = { velocity, glm::vec3( 0.f ) };
+    Lifetime lifetime = { LIFE, LIFE };
+    Health health = { 1 };
+    RenderMesh mesh = { prim, mat, 1.f, false };
+    Collider collider = { AABB( bbMin * MODEL_SCALE, bbMax * MODEL_SCALE ), LAYER_BULLET, LAYER_STATIC | LAYER_ENEMY | LAYER_CAKE };
+    world.transforms.add( e, transform );
+    world.velocities.add( e, motion );
+    world.lifetimes.add( e, lifetime );
+    world.healths.add( e, health );
+    world.meshes.add( e, mesh );
+    world.colliders.add( e, collider );
+    return e;
 }
-
-bool
-Bullet::isDead()
-const {
-    return m_life <= 0;
-}
\ No newline at end of file
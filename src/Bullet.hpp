@@ -7,30 +7,35 @@
 
 #pragma once
 
-#include "OpenGLImport.hpp"
-#include "GeometryNode.hpp"
+#include "Entity.hpp"
 #include <glm/glm.hpp>
 
 // forward decls
 class Material;
-class Shader;
 class Model;
+class World;
 
 /**
  * @brief Thing created by player that hurts enemies.
+ * @remark Bullets are entities in the level's World: a transform, velocity,
+ *         lifetime, one point of health, a mesh and a collider on
+ *         LAYER_BULLET. The level sweeps them and spends the health on a hit.
  */
-class Bullet : public GeometryNode {
+class Bullet {
 public:
     static const glm::vec3 MODEL_SCALE;
-    Bullet( Model * prim, Material * mat, Shader * shader, const glm::vec3 & position, const glm::vec3 & velocity );
 
-    virtual void update();
+    /** @brief How many timesteps a bullet survives. */
+    static const int LIFE;
 
-    bool isDead() const;
-
-private:
-    /** @brief Movement every second. */
-    glm::vec3 m_velocity;
-    /** @brief How many timesteps the bullet survives. */
-    int m_life;
+    /**
+     * @brief Create a new bullet.
+     * @param world Where to put the bullet.
+     * @param prim The bullet model.
+     * @param mat The bullet material.
+     * @param position Where it starts.
+     * @param velocity Movement every update.
+     * @return The bullet entity.
+     */
+    static Entity create( World & world, Model * prim, Material * mat, const glm::vec3 & position, const glm::vec3 & velocity );
 };
@@ -0,0 +1,30 @@
+/**
+ * @file Checksum.hpp
+ * @brief Hashing simulation state to tell whether two runs matched.
+ * @author Michael Hitchens
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/** @brief Value to start a checksum from. */
+const std::uint64_t CHECKSUM_START = 14695981039346656037ull;
+
+/**
+ * @brief Fold some bytes into a checksum (FNV-1a).
+ * @remark Hashes floats bit for bit, so runs only match if every result
+ *         was computed exactly the same way.
+ */
+inline std::uint64_t
+checksumBytes( std::uint64_t hash,
+               const void * data,
+               std::size_t size )
+{
+    const unsigned char * bytes = (const unsigned char *)data;
+    for ( std::size_t i = 0; i < size; i++ ) {
+        hash = ( hash ^ bytes[i] ) * 1099511628211ull;
+    }
+    return hash;
+}
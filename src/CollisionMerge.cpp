@@ -0,0 +1,77 @@
+#include "CollisionMerge.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// Level geometry is placed with float math so faces that should line up can be
+// a tiny bit off.
+static const float MERGE_EPSILON = 1e-4f;
+
+/** @brief Snap to the epsilon grid so sorting has a consistent order. */
+static long long
+quantize( float f )
+{
+    return std::llround( f / MERGE_EPSILON );
+}
+
+/**
+ * @brief Join boxes that touch end to end along one axis.
+ * @return true if anything was merged.
+ */
+static bool
+mergeAlongAxis( std::vector<CollisionBox> & boxes,
+                int axis )
+{
+    int u = ( axis + 1 ) % 3;
+    int v = ( axis + 2 ) % 3;
+
+    // Line up boxes with the same cross section, ordered along the axis, so
+    // mergeable boxes end up next to each other.
+    std::sort( boxes.begin(), boxes.end(), [&]( const CollisionBox & a, const CollisionBox & b ) {
+        long long ka[4] = { quantize( a.box.min[u] ), quantize( a.box.max[u] ), quantize( a.box.min[v] ), quantize( a.box.max[v] ) };
+        long long kb[4] = { quantize( b.box.min[u] ), quantize( b.box.max[u] ), quantize( b.box.min[v] ), quantize( b.box.max[v] ) };
+        for ( int i = 0; i < 4; i++ ) {
+            if ( ka[i] != kb[i] ) return ka[i] < kb[i];
+        }
+        return a.box.min[axis] < b.box.min[axis];
+    });
+
+    std::vector<CollisionBox> merged;
+    merged.reserve( boxes.size() );
+
+    for ( const CollisionBox & cb : boxes ) {
+        if ( !merged.empty() ) {
+            AABB & last = merged.back().box;
+            bool sameSection = quantize( last.min[u] ) == quantize( cb.box.min[u] ) &&
+                               quantize( last.max[u] ) == quantize( cb.box.max[u] ) &&
+                               quantize( last.min[v] ) == quantize( cb.box.min[v] ) &&
+                               quantize( last.max[v] ) == quantize( cb.box.max[v] );
+
+            // Touching or overlapping along the axis; either way the union is
+            // still a box.
+            if ( sameSection && cb.box.min[axis] <= last.max[axis] + MERGE_EPSILON ) {
+                last.max[axis] = std::max( last.max[axis], cb.box.max[axis] );
+                continue;
+            }
+        }
+        merged.push_back( cb );
+    }
+
+    bool changed = merged.size() != boxes.size();
+    boxes.swap( merged );
+    return changed;
+}
+
+void
+mergeCollisionBoxes( std::vector<CollisionBox> & boxes )
+{
+    // Each pass can make new merges possible on the other axes; stop once
+    // nothing changes. Grid levels settle after one or two rounds.
+    bool changed = true;
+    while ( changed ) {
+        changed = false;
+        changed |= mergeAlongAxis( boxes, 0 ); // X
+        changed |= mergeAlongAxis( boxes, 2 ); // Z
+        changed |= mergeAlongAxis( boxes, 1 ); // Y
+    }
+}
@@ -0,0 +1,35 @@
+/**
+ * @file CollisionMerge.hpp
+ * @brief Build step that merges static collision boxes.
+ * @author Michael Hitchens
+ */
+
+#pragma once
+
+#include "AABB.hpp"
+#include "Entity.hpp"
+
+#include <vector>
+
+/**
+ * @brief A box used only for collision detection plus what it came from.
+ */
+struct CollisionBox {
+    AABB box;
+    /** @brief The CollisionLayer the box is on. */
+    unsigned layer;
+    /** @brief The enemy the box belongs to; NULL_ENTITY for level scenery. */
+    Entity entity;
+};
+
+/**
+ * @brief Merge boxes that share a whole face into bigger boxes.
+ * @param boxes The boxes to merge; replaced with the merged set.
+ * @details Greedy meshing over box placements: first runs along X are joined,
+ *          then the resulting strips along Z, then slabs along Y. Boxes only
+ *          merge when the shared faces match exactly so the volume covered
+ *          never changes.
+ * @remark Meant for grid-aligned level geometry, which has no entity; the
+ *         entity of one of the boxes is kept. Irregular boxes are left alone.
+ */
+void mergeCollisionBoxes( std::vector<CollisionBox> & boxes );
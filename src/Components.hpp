@@ -0,0 +1,107 @@
+/**
+ * @file Components.hpp
+ * @brief Plain data attached to entities in a World.
+ * @author Michael Hitchens
+ */
+
+#pragma once
+
+#include "AABB.hpp"
+#include "AnimationState.hpp"
+#include "ParticleSystem.hpp"
+
+#include <glm/glm.hpp>
+
+// forward decls
+class Model;
+class Material;
+
+/**
+ * @brief Where an entity is and how big it is.
+ * @remark Drawn as translate( position ) * scale( scale ), the same order
+ *         SceneNode uses when scaled then translated.
+ */
+struct Transform {
+    glm::vec3 position;
+    glm::vec3 scale;
+    /** @brief Position before the last update; drawing blends from here. */
+    glm::vec3 previous;
+};
+
+/**
+ * @brief How an entity moves every update.
+ */
+struct Velocity {
+    /** @brief Added to the position every update. */
+    glm::vec3 linear;
+    /** @brief Added to linear every update, after moving. */
+    glm::vec3 acceleration;
+};
+
+/**
+ * @brief How many updates an entity has left.
+ */
+struct Lifetime {
+    /** @brief Updates left; the entity is removed once this reaches 0. */
+    int remaining;
+    /** @brief What remaining started at, for fading out. */
+    int start;
+};
+
+/**
+ * @brief How much damage an entity can take.
+ */
+struct Health {
+    /** @brief The entity is removed once this reaches 0. */
+    int points;
+};
+
+/**
+ * @brief A model drawn at the entity's transform.
+ * @remark Drawn at the first keyframe unless the entity also has an
+ *         AnimationState, which plays through the model's keyframes.
+ */
+struct RenderMesh {
+    Model * model;
+    Material * material;
+    float alpha;
+    /** @brief Set alpha from the lifetime so the entity fades as it ages. */
+    bool fadeOut;
+};
+
+/**
+ * @brief A box that takes part in collision detection.
+ */
+struct Collider {
+    /** @brief Scaled model box; add the transform position for world space. */
+    AABB box;
+    /** @brief Which CollisionLayer this is on. */
+    unsigned layer;
+    /** @brief Which collision layers this runs into. */
+    unsigned mask;
+};
+
+/**
+ * @brief What an enemy is doing; see Enemy.
+ */
+struct EnemyState {
+    /** @brief One of EnemyStates. */
+    int state;
+    /** @brief Distance walked every update. */
+    float speed;
+    /** @brief Unit direction of the last move; zero if it didn't move. */
+    glm::vec3 heading;
+    /** @brief Whether it thought since the last update. */
+    bool thought;
+    /** @brief Whether it's drawn with Enemy::hurt_material this update. */
+    bool hurt;
+    /** @brief What it's drawn with when not hurt. */
+    Material * material;
+};
+
+/**
+ * @brief Spawns particles every update while its lifetime lasts.
+ */
+struct Emitter {
+    ParticleSystemConfig config;
+};
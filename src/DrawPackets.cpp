@@ -0,0 +1,97 @@
+#include "DrawPackets.hpp"
+
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+// Key layout, most significant bit first:
+//   opaque:      0 | model (16) | material (15) | depth (32), near first
+//   translucent: 1 | unused (31)                | depth (32), far first
+static const std::uint64_t KEY_TRANSLUCENT = 1ull << 63;
+static const int KEY_MODEL_SHIFT = 47;
+static const int KEY_MATERIAL_SHIFT = 32;
+
+/** @brief Fold a pointer into a few bits; equal pointers give equal bits. */
+static std::uint64_t
+hashPointer( const void * p,
+             int bits )
+{
+    std::uint64_t h = (std::uint64_t)(std::uintptr_t)p;
+    h ^= h >> 29;
+    h *= 0x9E3779B97F4A7C15ull;
+    return h >> ( 64 - bits );
+}
+
+/** @brief Bits of a non-negative float, which sort the same as the float. */
+static std::uint32_t
+depthBits( float depth )
+{
+    if ( !( depth > 0.f ) ) depth = 0.f;
+    std::uint32_t bits;
+    memcpy( &bits, &depth, sizeof( bits ) );
+    return bits;
+}
+
+DrawPackets::DrawPackets():
+    m_V(),
+    m_buffers(),
+    m_order()
+{
+    // nothing else to do
+}
+
+void
+DrawPackets::begin( const glm::mat4 & V )
+{
+    m_V = V;
+    m_buffers.resize( JobSystem::getInstance()->getThreadCount() );
+    for ( std::vector<Packet> & buffer : m_buffers ) {
+        buffer.clear();
+    }
+}
+
+void
+DrawPackets::add( const DrawItem & item )
+{
+    Packet packet = { makeSortKey( item ), item };
+    m_buffers[JobSystem::getInstance()->getThreadIndex()].push_back( packet );
+}
+
+void
+DrawPackets::merge( std::vector<DrawItem> & out )
+{
+    m_order.clear();
+    for ( const std::vector<Packet> & buffer : m_buffers ) {
+        for ( const Packet & packet : buffer ) {
+            m_order.push_back( std::make_pair( packet.key, &packet ) );
+        }
+    }
+
+    // Sort small pairs instead of whole items, then copy each item once
+    std::sort( m_order.begin(), m_order.end(),
+        []( const std::pair<std::uint64_t, const Packet *> & a,
+            const std::pair<std::uint64_t, const Packet *> & b ) {
+            return a.first < b.first;
+        });
+
+    out.reserve( out.size() + m_order.size() );
+    for ( const std::pair<std::uint64_t, const Packet *> & entry : m_order ) {
+        out.push_back( entry.second->item );
+    }
+}
+
+std::uint64_t
+DrawPackets::makeSortKey( const DrawItem & item )
+const {
+    // distance in front of the camera
+    float depth = -( m_V * item.M[3] ).z;
+
+    if ( item.alpha < 1.f ) {
+        return KEY_TRANSLUCENT | ( ~depthBits( depth ) & 0xFFFFFFFFull );
+    }
+
+    return ( hashPointer( item.model, 16 ) << KEY_MODEL_SHIFT ) |
+           ( hashPointer( item.material, 15 ) << KEY_MATERIAL_SHIFT ) |
+           depthBits( depth );
+}
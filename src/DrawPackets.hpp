@@ -0,0 +1,60 @@
+/**
+ * @file DrawPackets.hpp
+ * @brief Interface for DrawPackets
+ * @author Michael Hitchens
+ */
+
+#pragma once
+
+#include "RenderSnapshot.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Draw items made by many jobs at once, merged into draw order.
+ * @details Each thread adds to a buffer of its own so no locks are needed
+ *          while items are made. merge() then sorts everything by a key:
+ *          opaque items first, grouped by model and material so the renderer
+ *          rebinds less, then translucent items back to front so they blend
+ *          over what's behind them.
+ * @remark Buffers keep their memory between frames.
+ */
+class DrawPackets {
+public:
+    DrawPackets();
+
+    /**
+     * @brief Start collecting a new frame.
+     * @param V The view matrix the frame is seen through; used for depth.
+     */
+    void begin( const glm::mat4 & V );
+
+    /**
+     * @brief Add an item to the calling thread's buffer.
+     * @remark Safe to call from JobSystem jobs started by the thread that
+     *         called begin().
+     */
+    void add( const DrawItem & item );
+
+    /** @brief Append everything added since begin() to out, in draw order. */
+    void merge( std::vector<DrawItem> & out );
+
+private:
+    struct Packet {
+        std::uint64_t key;
+        DrawItem item;
+    };
+
+    /** @brief Compute where an item goes in the draw order. */
+    std::uint64_t makeSortKey( const DrawItem & item ) const;
+
+    glm::mat4 m_V;
+    /** @brief One buffer per JobSystem thread. */
+    std::vector<std::vector<Packet>> m_buffers;
+    /** @brief Sort keys and where to find their packets, for merge(). */
+    std::vector<std::pair<std::uint64_t, const Packet *>> m_order;
+};
@@ -1,135 +1,319 @@
 #include "Enemy.hpp"
 
 #include "Model.hpp"
-#include "Material.hpp"
-#include "Shader.hpp"
 #include "Player.hpp"
-#include <glm/glm.hpp>
 #include "Level.hpp"
-#include "globals.hpp"
+#include "World.hpp"
+#include "JobSystem.hpp"
+#include "SpatialHash.hpp"
 #include "ParticleSystem.hpp"
 #include "globals.hpp"
 #include "SoundCache.hpp"
 #include "ModelCache.hpp"
 
+#include <algorithm>
+
 // set in main.cpp
 Material * Enemy::hurt_material = nullptr;
 
-Enemy::Enemy( Model * prim,
-              Material * mat,
-              Shader * shader,
-              Level * level ):
-    GeometryNode( prim, mat, shader ),
-    m_life(1),
-    m_wasHurt(false),
-    m_level( level ),
-    m_speed(0.01),
-    m_state(ENEMY_STATE_SPAWNING)
+const double Enemy::DAMAGE = 0.1;
+
+Entity
+Enemy::create( World & world,
+               Model * prim,
+               Material * mat,
+               const glm::vec3 & position )
 {
     double r = ParticleSystem::random();
 
+    int life = 1;
     double meanlife = global_difficulty / 20.0;
     double varlife = global_difficulty / 10.0;
     int newlife = (int)(meanlife + r * varlife);
     if ( newlife > 0 ) {
-        m_life = newlife;
+        life = newlife;
     }
 
     r = ParticleSystem::random();
 
+    double speed = 0.01;
     double meanspeed = global_difficulty / 1000.0;
     double varspeed = global_difficulty / 3000.0;
     double newspeed = meanspeed + r * varspeed;
     if ( newspeed >= 0.01 ) {
-        m_speed = newspeed;
+        speed = newspeed;
     }
 
-    setModel( ModelCache::getInstance()->getAnimation( "spike_spawn" ) );
+    glm::vec3 bbMin, bbMax;
+    prim->getBoundingBox( bbMin, bbMax );
+    Model * spawn = ModelCache::getInstance()->getAnimation( "spike_spawn" );
+
+    Entity e = world.create();
+    Transform transform = { position, glm::vec3( 1.f ), position };
+    Velocity motion = { glm::vec3( 0.f ), glm::vec3( 0.f ) };
+    Health health = { life };
+    RenderMesh mesh = { spawn, mat, 1.f, false };
+    AnimationState anim;
+    startAnimation( anim, spawn );
+    Collider collider = { AABB( bbMin, bbMax ), LAYER_ENEMY, LAYER_PLAYER | LAYER_CAKE };
+    EnemyState state = { ENEMY_STATE_SPAWNING, (float)speed, glm::vec3( 0.f ), false, false, mat };
+    world.transforms.add( e, transform );
+    world.velocities.add( e, motion );
+    world.healths.add( e, health );
+    world.meshes.add( e, mesh );
+    world.animations.add( e, anim );
+    world.colliders.add( e, collider );
+    world.enemies.add( e, state );
+    return e;
 }
 
+// Crowd steering tuning. Enemies are about a unit wide.
+static const float CROWD_RADIUS = 1.5f;
+static const float SEPARATION_WEIGHT = 1.5f;
+static const float ALIGNMENT_WEIGHT = 0.3f;
+
+// AI scheduling. Enemies closer than this to a target think every update.
+static const float AI_NEAR_DISTANCE = 8.f;
+// Far enemies think at least this often...
+static const int AI_MIN_PERIOD = 4;
+// ... or less often, so no more than this many far enemies think per update
+static const int AI_THINK_BUDGET = 64;
+// Thinking enemies per job
+static const int AI_GRAIN = 32;
+// Sight rays run along both sides of an enemy so it doesn't clip corners
+static const float SIGHT_HALF_WIDTH = 0.5f;
+
 void
-Enemy::update()
+thinkEnemies( World & world,
+              Level & level,
+              SpatialHash & crowd,
+              int frame )
 {
-    Player * player = Player::getInstance();
+    int count = world.enemies.size();
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> headings;
+    positions.reserve( count );
+    headings.reserve( count );
+    for ( int i = 0; i < count; i++ ) {
+        const Transform * t = world.transforms.find( world.enemies.getEntity( i ) );
+        positions.push_back( t ? t->position : glm::vec3( 0.f ) );
+        headings.push_back( world.enemies[i].heading );
+    }
+
+    // Near or far from whatever they're heading for
+    const std::vector<glm::vec3> & targets = level.getFlowTargets();
+    std::vector<bool> near( count, false );
+    int farCount = 0;
+    for ( int i = 0; i < count; i++ ) {
+        for ( const glm::vec3 & target : targets ) {
+            glm::vec3 d = target - positions[i];
+            d.y = 0;
+            if ( glm::dot( d, d ) < AI_NEAR_DISTANCE * AI_NEAR_DISTANCE ) near[i] = true;
+        }
+        if ( !near[i] ) farCount++;
+    }
+
+    int period = std::max( AI_MIN_PERIOD, ( farCount + AI_THINK_BUDGET - 1 ) / AI_THINK_BUDGET );
+
+    crowd.build( positions, CROWD_RADIUS );
+
+    // Only living enemies walk anywhere. Far enemies are bucketed by entity
+    // slot, which stays put while others are removed around them, unlike
+    // their position in the array.
+    std::vector<int> thinkers;
+    for ( int i = 0; i < count; i++ ) {
+        if ( world.enemies[i].state != ENEMY_STATE_LIVING ) continue;
 
-    GeometryNode::update();
+        unsigned slot = world.enemies.getEntity( i ) & ENTITY_INDEX_MASK;
+        if ( near[i] || ( frame + slot ) % period == 0 ) thinkers.push_back( i );
+    }
+
+    // Walk straight at the nearest target if it can be seen; the flow field
+    // only knows which cell to go to next. Both sides of an enemy have to see
+    // it, so its rays go in pairs.
+    std::vector<glm::vec3> sightTargets( thinkers.size() );
+    std::vector<glm::vec3> origins;
+    std::vector<glm::vec3> directions;
+    origins.reserve( 2 * thinkers.size() );
+    directions.reserve( 2 * thinkers.size() );
+    float sightRange = 0.f;
+    for ( std::size_t k = 0; k < thinkers.size(); k++ ) {
+        const glm::vec3 & position = positions[thinkers[k]];
+        glm::vec3 toTarget( 0.f );
+        float best = -1.f;
+        for ( const glm::vec3 & target : targets ) {
+            glm::vec3 d = target - position;
+            d.y = 0;
+            if ( best < 0.f || glm::dot( d, d ) < best ) {
+                best = glm::dot( d, d );
+                toTarget = d;
+            }
+        }
 
-    if ( m_state == ENEMY_STATE_SPAWNING ) {
-        if ( m_keyframe == 1 ) {
-            m_state = ENEMY_STATE_LIVING;
-            setModel( ModelCache::getInstance()->getAnimation( "spike_living" ) );
+        glm::vec3 side( 0.f );
+        if ( toTarget != glm::vec3( 0.f ) ) {
+            side = SIGHT_HALF_WIDTH * glm::normalize( glm::vec3( -toTarget.z, 0.f, toTarget.x ) );
         }
-    } else if ( m_state == ENEMY_STATE_LIVING ) {
-        glm::vec3 movement = glm::normalize(glm::vec3(0, 0, 0) - getLocation());
-        movement = (float)m_speed * movement;
-        movement.y = 0;
-        translate(movement);
-
-        if ( isCollidingWith( *player ) ) {
-            translate( -1.f * movement );
-            player->hurt( getDamage() );
-
-            if ( warning_timer <= 0 ) {
-                warning_timer = warning_cooldown;
-                SoundCache::getInstance()->playSound( "Assets/Laser_Shoot3.wav" );
+        sightTargets[k] = toTarget;
+        origins.push_back( position + side );
+        origins.push_back( position - side );
+        directions.push_back( toTarget );
+        directions.push_back( toTarget );
+        sightRange = std::max( sightRange, glm::length( toTarget ) );
+    }
+
+    std::vector<RayHit> sight;
+    level.raycastMany( origins, directions, sightRange, LAYER_STATIC, sight );
+
+    // Each enemy only reads the shared arrays and the flow field and writes
+    // its own state and velocity, so the iterations don't depend on each
+    // other and can run on any thread.
+    JobSystem::getInstance()->parallelFor( thinkers.size(), AI_GRAIN, [&]( int begin, int end ) {
+        std::vector<int> neighbours;
+        for ( int k = begin; k < end; k++ ) {
+            int i = thinkers[k];
+
+            neighbours.clear();
+            crowd.findNeighbours( positions[i], CROWD_RADIUS, neighbours );
+
+            glm::vec3 separation( 0.f );
+            glm::vec3 alignment( 0.f );
+            int neighbourCount = 0;
+            for ( int j : neighbours ) {
+                if ( j == i ) continue;
+
+                glm::vec3 away = positions[i] - positions[j];
+                away.y = 0;
+                float distance = glm::length( away );
+
+                // Push harder the closer they are; stacked enemies get split
+                // apart along some arbitrary but consistent direction
+                if ( distance > 0.f ) {
+                    separation += away * ( ( CROWD_RADIUS - distance ) / ( CROWD_RADIUS * distance ) );
+                } else {
+                    separation += i < j ? glm::vec3( 1.f, 0.f, 0.f ) : glm::vec3( -1.f, 0.f, 0.f );
+                }
+                alignment += headings[j];
+                neighbourCount++;
             }
 
-        } else if ( m_level->findCakeCollision( *this ) ) {
-            translate( -1.f * movement );
-            player->hurt( getDamage() );
+            glm::vec3 steering( 0.f );
+            if ( neighbourCount > 0 ) {
+                alignment = alignment / (float)neighbourCount - headings[i];
+                steering = SEPARATION_WEIGHT * separation + ALIGNMENT_WEIGHT * alignment;
+            }
 
-            if ( warning_timer <= 0 ) {
-                warning_timer = warning_cooldown;
-                SoundCache::getInstance()->playSound( "Assets/Laser_Shoot3.wav" );
+            // The level knows the way around obstacles to the cake or player;
+            // the crowd pushes us away from the enemies around us
+            const glm::vec3 & toTarget = sightTargets[k];
+            float distance = glm::length( toTarget );
+            bool seen = distance > 0.f;
+            for ( int r = 2 * k; r < 2 * k + 2 && seen; r++ ) {
+                if ( sight[r].layer != LAYER_NONE && sight[r].distance < distance ) seen = false;
             }
+            glm::vec3 direction = ( seen ? toTarget / distance : level.getFlowDirection( positions[i] ) ) + steering;
+            direction.y = 0;
+            if ( direction != glm::vec3( 0.f ) ) direction = glm::normalize( direction );
+
+            EnemyState & enemy = world.enemies[i];
+            enemy.heading = direction;
+            enemy.thought = true;
+            Velocity * v = world.velocities.find( world.enemies.getEntity( i ) );
+            if ( v ) v->linear = enemy.speed * direction;
         }
-    } else {
-        // derp
-    }
+    });
 }
 
 void
-Enemy::decrementLife()
+updateEnemies( World & world,
+               Level & level )
 {
-    if ( m_state != ENEMY_STATE_LIVING ) return;
-
-    m_life--;
-    m_wasHurt = true;
-    if ( m_life <= 0 ) {
-        m_state = ENEMY_STATE_DYING;
-        setModel( ModelCache::getInstance()->getAnimation( "spike_dying" ) );
-        setSolid( false );
-        SoundCache::getInstance()->playSound( "Assets/Laser_Shoot11.wav" );
-        global_difficulty++;
-        global_kills++;
-    } else {
-        SoundCache::getInstance()->playSound( "Assets/Hit_Hurt13.wav" );
-    }
-}
+    Player * player = Player::getInstance();
+    glm::vec3 playerMin, playerMax;
+    player->getBoundingBox( playerMin, playerMax );
+    AABB playerBox( playerMin, playerMax );
+
+    for ( int i = 0; i < world.enemies.size(); i++ ) {
+        EnemyState & enemy = world.enemies[i];
+        Entity e = world.enemies.getEntity( i );
+        RenderMesh * mesh = world.meshes.find( e );
+        AnimationState * anim = world.animations.find( e );
+        if ( !mesh || !anim ) continue;
 
-bool
-Enemy::isDead()
-const {
-    return m_state == ENEMY_STATE_DYING && m_keyframe != 0;
+        if ( enemy.hurt ) {
+            enemy.hurt = false;
+            mesh->material = enemy.material;
+        }
+
+        if ( enemy.state == ENEMY_STATE_SPAWNING ) {
+            if ( anim->keyframe == 1 ) {
+                enemy.state = ENEMY_STATE_LIVING;
+                mesh->model = ModelCache::getInstance()->getAnimation( "spike_living" );
+                startAnimation( *anim, mesh->model );
+            }
+        } else if ( enemy.state == ENEMY_STATE_LIVING ) {
+            // Between thinks keep going the same way without looking
+            if ( !enemy.thought ) continue;
+            enemy.thought = false;
+
+            Transform * t = world.transforms.find( e );
+            Velocity * v = world.velocities.find( e );
+            const Collider * c = world.colliders.find( e );
+            if ( !t || !v || !c ) continue;
+
+            AABB box = c->box.translated( t->position );
+            bool touching = ( ( c->mask & LAYER_PLAYER ) && box.overlaps( playerBox ) ) ||
+                            ( ( c->mask & LAYER_CAKE ) && level.findCakeCollision( box ) );
+            if ( touching ) {
+                t->position = t->previous;
+                v->linear = glm::vec3( 0.f );
+                player->hurt( Enemy::DAMAGE );
+
+                if ( warning_timer <= 0 ) {
+                    warning_timer = warning_cooldown;
+                    SoundCache::getInstance()->playSound( "Assets/Laser_Shoot3.wav" );
+                }
+            }
+        }
+    }
 }
 
 void
-Enemy::draw( glm::mat4 accum )
+damageEnemies( World & world,
+               const std::vector<Entity> & hits )
 {
-    Material * old_mat = nullptr;
-    if ( m_wasHurt ) {
-        old_mat = getMaterial();
-        setMaterial( Enemy::hurt_material );
-    }
-    GeometryNode::draw( accum );
-    if ( m_wasHurt ) {
-        m_wasHurt = false;
-        setMaterial( old_mat );
+    for ( Entity e : hits ) {
+        // dying enemies have no health left to take
+        EnemyState * enemy = world.enemies.find( e );
+        Health * health = world.healths.find( e );
+        if ( !enemy || !health || enemy->state != ENEMY_STATE_LIVING ) continue;
+
+        health->points--;
+        enemy->hurt = true;
+        RenderMesh * mesh = world.meshes.find( e );
+        if ( mesh ) mesh->material = Enemy::hurt_material;
+
+        if ( health->points > 0 ) {
+            SoundCache::getInstance()->playSound( "Assets/Hit_Hurt13.wav" );
+            continue;
+        }
+
+        // Gone once the dying animation's first keyframe has played
+        enemy->state = ENEMY_STATE_DYING;
+        Model * dying = ModelCache::getInstance()->getAnimation( "spike_dying" );
+        if ( mesh ) mesh->model = dying;
+        AnimationState * anim = world.animations.find( e );
+        if ( anim ) startAnimation( *anim, dying );
+        int length = dying->getFrameLength( 0 );
+        Lifetime lifetime = { length, length };
+        world.lifetimes.add( e, lifetime );
+        world.healths.remove( e );
+        world.colliders.remove( e );
+        Velocity * v = world.velocities.find( e );
+        if ( v ) v->linear = glm::vec3( 0.f );
+
+        SoundCache::getInstance()->playSound( "Assets/Laser_Shoot11.wav" );
+        global_difficulty++;
+        global_kills++;
     }
 }
-
-double
-Enemy::getDamage() const
-{
-    return 0.1;
-}
\ No newline at end of file
@@ -7,14 +7,17 @@
 
 #pragma once
 
-#include "OpenGLImport.hpp"
-#include "GeometryNode.hpp"
+#include "Entity.hpp"
+#include <glm/glm.hpp>
+
+#include <vector>
 
 // forward decls
 class Material;
-class Shader;
 class Model;
 class Level;
+class SpatialHash;
+class World;
 
 enum EnemyStates {
     ENEMY_STATE_SPAWNING,
@@ -24,34 +27,64 @@ enum EnemyStates {
 
 /**
  * @brief Something that runs after the player
+ * @remark Enemies are entities in the level's World: a transform, velocity,
+ *         health, mesh, animation, collider on LAYER_ENEMY and an
+ *         EnemyState. The systems below do the rest.
  */
-class Enemy : public GeometryNode {
+class Enemy {
 public:
     static Material * hurt_material;
 
+    /** @brief Damage done to the player each update an enemy touches it. */
+    static const double DAMAGE;
+
     /**
-     * @brief Create a new node that combines a model, some texture, and the way
-     *        to render the two.
-     * @param prim The model to use.
-     * @param mat The material to draw the model.
-     * @param shader How to apply the material.
+     * @brief Create a new enemy, spawning.
+     * @param world Where to put the enemy.
+     * @param prim The model its collision box comes from.
+     * @param mat The enemy material.
+     * @param position Where it spawns.
+     * @return The enemy entity.
+     * @remark Health and speed are rolled from global_difficulty.
      */
-    Enemy( Model * prim, Material * mat, Shader * shader, Level * level );
-
-    /** @brief Update node state, if needed. */
-    virtual void update();
-
-    virtual void draw( glm::mat4 accum );
+    static Entity create( World & world, Model * prim, Material * mat, const glm::vec3 & position );
+};
 
-    void decrementLife();
+/**
+ * @brief AI system: decide which way enemies walk.
+ * @param level Where the flow field and its targets come from, and what
+ *              blocks sight.
+ * @param crowd Rebuilt with every enemy's position.
+ * @param frame Counts updates; picks which far enemies think.
+ * @details Enemies near the cake or player think every update. The rest are
+ *          split into round-robin buckets and think once every few updates,
+ *          carrying on in a straight line in between. The number of buckets
+ *          grows with the enemy count to keep the work per update about the
+ *          same.
+ * @remark Thinking enemies that can see their nearest target walk straight
+ *         at it; the rest follow the flow field around what's in the way.
+ *         Sight is one batch of rays for every thinker.
+ * @remark Thinking enemies get a push away from their neighbours
+ *         (separation) and towards their average heading (alignment).
+ *         Neighbours come from the crowd hash so each enemy only looks at the
+ *         cells around it.
+ */
+void thinkEnemies( World & world, Level & level, SpatialHash & crowd, int frame );
 
-    bool isDead() const;
+/**
+ * @brief Enemy system: animate, grow out of spawning and stop at the player
+ *        or cake.
+ * @remark Run after integrateMotion. Enemies that thought this update and
+ *         ran into the player or cake are put back, stop and hurt the player.
+ *         Also ends the hurt flash from the last update's damage.
+ */
+void updateEnemies( World & world, Level & level );
 
-    double getDamage() const;
-private:
-    int m_life;
-    bool m_wasHurt;
-    Level * m_level;
-    double m_speed;
-    int m_state;
-};
+/**
+ * @brief Damage system: take a point of health from each enemy hit.
+ * @param hits The enemies hit, in order; the same one can be hit again.
+ * @remark Living enemies that run out start dying: they stop, stop being
+ *         solid and get a lifetime as long as their dying animation, so
+ *         removeDeadEntities() takes them away when it ends.
+ */
+void damageEnemies( World & world, const std::vector<Entity> & hits );
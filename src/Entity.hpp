@@ -0,0 +1,22 @@
+/**
+ * @file Entity.hpp
+ * @brief Handles to things in a World.
+ * @author Michael Hitchens
+ */
+
+#pragma once
+
+/**
+ * @brief Handle to something in a World.
+ * @details The low bits are a slot index and the high bits count how many
+ *          times that slot has been reused, so a handle to a destroyed entity
+ *          never matches whatever takes its slot.
+ */
+typedef unsigned Entity;
+
+/** @brief Handle that never refers to anything. */
+const Entity NULL_ENTITY = 0xFFFFFFFFu;
+
+/** @brief Number of bits in an Entity used for the slot index. */
+const unsigned ENTITY_INDEX_BITS = 20;
+const unsigned ENTITY_INDEX_MASK = ( 1u << ENTITY_INDEX_BITS ) - 1;
@@ -0,0 +1,260 @@
+#include "FlowField.hpp"
+
+#include <cmath>
+#include <limits>
+
+const float FlowField::UNREACHABLE = std::numeric_limits<float>::max();
+
+// The 8 neighbours: orthogonal ones first
+static const int NEIGHBOUR_X[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+static const int NEIGHBOUR_Z[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+static const float NEIGHBOUR_COST[8] = { 1.f, 1.f, 1.f, 1.f, 1.41421356f, 1.41421356f, 1.41421356f, 1.41421356f };
+// Open lists kept while computing a field; steps cost less than 2
+static const int OPEN_BUCKETS = 3;
+
+FlowField::FlowField():
+    m_min( 0.f ),
+    m_width( 0 ),
+    m_depth( 0 ),
+    m_cellSize( 1.f ),
+    m_blocked(),
+    m_targetCost(),
+    m_cost(),
+    m_direction(),
+    m_targetCells(),
+    m_dirty( false )
+{
+    // nothing else to do
+}
+
+void
+FlowField::resize( const glm::vec2 & min,
+                   int width,
+                   int depth,
+                   float cellSize )
+{
+    m_min = min;
+    m_width = width;
+    m_depth = depth;
+    m_cellSize = cellSize;
+
+    int count = width * depth;
+    m_blocked.assign( count, false );
+    m_targetCost.clear();
+    m_cost.assign( count, UNREACHABLE );
+    m_direction.assign( count, glm::vec2( 0.f ) );
+    m_targetCells.clear();
+    m_dirty = true;
+}
+
+void
+FlowField::clear()
+{
+    resize( glm::vec2( 0.f ), 0, 0, 1.f );
+    m_dirty = false;
+}
+
+bool
+FlowField::empty()
+const {
+    return m_blocked.empty();
+}
+
+void
+FlowField::setBlocked( int x,
+                       int z,
+                       bool blocked )
+{
+    m_blocked[z * m_width + x] = blocked;
+    m_dirty = true;
+}
+
+glm::vec2
+FlowField::getCellCenter( int x,
+                          int z )
+const {
+    return m_min + ( glm::vec2( x, z ) + 0.5f ) * m_cellSize;
+}
+
+int
+FlowField::getWidth()
+const {
+    return m_width;
+}
+
+int
+FlowField::getDepth()
+const {
+    return m_depth;
+}
+
+float
+FlowField::getCellSize()
+const {
+    return m_cellSize;
+}
+
+int
+FlowField::cellAt( const glm::vec3 & position )
+const {
+    int x = (int)std::floor( ( position.x - m_min.x ) / m_cellSize );
+    int z = (int)std::floor( ( position.z - m_min.y ) / m_cellSize );
+    if ( x < 0 || z < 0 || x >= m_width || z >= m_depth ) return -1;
+    return z * m_width + x;
+}
+
+bool
+FlowField::setTargets( const std::vector<glm::vec3> & targets )
+{
+    if ( empty() ) return false;
+
+    std::vector<int> cells;
+    for ( const glm::vec3 & target : targets ) {
+        int cell = cellAt( target );
+        if ( cell >= 0 ) cells.push_back( cell );
+    }
+
+    if ( !m_dirty && cells == m_targetCells ) return false;
+
+    // Targets are matched up by order; only the ones in a new cell are redone
+    m_targetCost.resize( cells.size() );
+    for ( std::size_t i = 0; i < cells.size(); i++ ) {
+        if ( m_dirty || i >= m_targetCells.size() || cells[i] != m_targetCells[i] ) {
+            computeField( cells[i], m_targetCost[i] );
+        }
+    }
+
+    m_targetCells.swap( cells );
+    m_dirty = false;
+    combineFields();
+    return true;
+}
+
+void
+FlowField::computeField( int targetCell,
+                         std::vector<float> & cost )
+const {
+    cost.assign( m_blocked.size(), UNREACHABLE );
+
+    // Open cells bucketed by whole units of cost (Dial's algorithm). Steps
+    // cost at least one unit, so no cell can lower another in its own bucket
+    // and each bucket can be taken in any order. Steps cost under two units,
+    // so only the next OPEN_BUCKETS - 1 buckets are ever in use; they're
+    // reused round robin.
+    std::vector<int> open[OPEN_BUCKETS];
+    std::vector<bool> closed( m_blocked.size(), false );
+
+    // Seed the target. A target stuck in something solid seeds everything
+    // solid it's touching instead so there's a walkable edge to head for.
+    cost[targetCell] = 0.f;
+    open[0].push_back( targetCell );
+    if ( m_blocked[targetCell] ) {
+        std::vector<int> region( 1, targetCell );
+        while ( !region.empty() ) {
+            int c = region.back();
+            region.pop_back();
+            int cx = c % m_width;
+            int cz = c / m_width;
+            for ( int n = 0; n < 4; n++ ) {
+                int x = cx + NEIGHBOUR_X[n];
+                int z = cz + NEIGHBOUR_Z[n];
+                if ( x < 0 || z < 0 || x >= m_width || z >= m_depth ) continue;
+
+                int next = z * m_width + x;
+                if ( !m_blocked[next] || cost[next] == 0.f ) continue;
+                cost[next] = 0.f;
+                open[0].push_back( next );
+                region.push_back( next );
+            }
+        }
+    }
+
+    // Integration field: Dijkstra out from the seeds over walkable cells
+    int pending = open[0].size();
+    for ( int bucket = 0; pending > 0; bucket++ ) {
+        std::vector<int> & current = open[bucket % OPEN_BUCKETS];
+        for ( std::size_t i = 0; i < current.size(); i++ ) {
+            int cell = current[i];
+            if ( closed[cell] ) continue; // lowered since, or seen twice
+            closed[cell] = true;
+
+            int cx = cell % m_width;
+            int cz = cell / m_width;
+            for ( int n = 0; n < 8; n++ ) {
+                int x = cx + NEIGHBOUR_X[n];
+                int z = cz + NEIGHBOUR_Z[n];
+                if ( x < 0 || z < 0 || x >= m_width || z >= m_depth ) continue;
+
+                int next = z * m_width + x;
+                if ( m_blocked[next] ) continue;
+
+                // Don't squeeze diagonally between two blocked cells
+                if ( n >= 4 && ( m_blocked[cz * m_width + x] || m_blocked[z * m_width + cx] ) ) continue;
+
+                float step = cost[cell] + NEIGHBOUR_COST[n];
+                if ( step < cost[next] ) {
+                    cost[next] = step;
+                    open[(int)step % OPEN_BUCKETS].push_back( next );
+                    pending++;
+                }
+            }
+        }
+        pending -= current.size();
+        current.clear();
+    }
+}
+
+void
+FlowField::combineFields()
+{
+    // The nearest target is whichever is cheapest to walk to
+    m_cost.assign( m_blocked.size(), UNREACHABLE );
+    for ( const std::vector<float> & cost : m_targetCost ) {
+        for ( std::size_t i = 0; i < cost.size(); i++ ) {
+            if ( cost[i] < m_cost[i] ) m_cost[i] = cost[i];
+        }
+    }
+    m_direction.assign( m_blocked.size(), glm::vec2( 0.f ) );
+
+    // Direction field: point each walkable cell at its cheapest neighbour.
+    // Seeds keep a zero direction; agents there head straight for the target.
+    for ( int cz = 0; cz < m_depth; cz++ ) {
+        for ( int cx = 0; cx < m_width; cx++ ) {
+            int cell = cz * m_width + cx;
+            if ( m_blocked[cell] || m_cost[cell] == 0.f || m_cost[cell] == UNREACHABLE ) continue;
+
+            float best = m_cost[cell];
+            int bestN = -1;
+            for ( int n = 0; n < 8; n++ ) {
+                int x = cx + NEIGHBOUR_X[n];
+                int z = cz + NEIGHBOUR_Z[n];
+                if ( x < 0 || z < 0 || x >= m_width || z >= m_depth ) continue;
+                if ( n >= 4 && ( m_blocked[cz * m_width + x] || m_blocked[z * m_width + cx] ) ) continue;
+
+                int next = z * m_width + x;
+                if ( m_cost[next] < best ) {
+                    best = m_cost[next];
+                    bestN = n;
+                }
+            }
+
+            if ( bestN >= 0 ) {
+                m_direction[cell] = glm::normalize( glm::vec2( NEIGHBOUR_X[bestN], NEIGHBOUR_Z[bestN] ) );
+            }
+        }
+    }
+}
+
+bool
+FlowField::sample( const glm::vec3 & position,
+                   glm::vec3 & out_direction )
+const {
+    int cell = cellAt( position );
+    if ( cell < 0 ) return false;
+
+    const glm::vec2 & d = m_direction[cell];
+    if ( d.x == 0.f && d.y == 0.f ) return false;
+
+    out_direction = glm::vec3( d.x, 0.f, d.y );
+    return true;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file FlowField.hpp
+ * @brief Interface for FlowField
+ * @author Michael Hitchens
+ */
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+/**
+ * @brief Grid over the XZ plane telling anything on it which way to walk to
+ *        the nearest target.
+ * @details Each target keeps its own integration field (path cost to that
+ *          target, Dijkstra over 8 neighbours). The nearest target is the
+ *          cheapest of them, and a direction field (towards the cheapest
+ *          neighbour) is computed from that once for every agent. Agents only
+ *          look up the cell they're in.
+ * @remark Diagonal moves past blocked corners aren't allowed, so following the
+ *         field never cuts through a wall.
+ */
+class FlowField {
+public:
+    FlowField();
+
+    /**
+     * @brief Set up an empty grid; every cell starts walkable.
+     * @param min The world XZ corner of cell (0, 0).
+     * @param width Number of cells along X.
+     * @param depth Number of cells along Z.
+     * @param cellSize World size of each square cell.
+     */
+    void resize( const glm::vec2 & min, int width, int depth, float cellSize );
+
+    /** @brief Forget the grid. */
+    void clear();
+
+    /** @brief Get whether there's no grid. */
+    bool empty() const;
+
+    /** @brief Mark a cell as something agents can't walk through. */
+    void setBlocked( int x, int z, bool blocked );
+
+    /** @brief Get the world XZ center of a cell. */
+    glm::vec2 getCellCenter( int x, int z ) const;
+
+    int getWidth() const;
+
+    int getDepth() const;
+
+    float getCellSize() const;
+
+    /**
+     * @brief Point the field at some targets.
+     * @param targets World positions to walk to; the nearest one wins.
+     * @return true if the field was recomputed.
+     * @remark Only the integration fields of targets that moved to another
+     *         cell are recomputed, or all of them after the grid changes, so
+     *         calling this every timestep is cheap and a target that never
+     *         moves (the cake) is only paid for once. A target's field is
+     *         redone in full when it moves because the cost of every cell to
+     *         it changes.
+     *         A target inside a blocked cell (the cake on its table) seeds the
+     *         whole blocked region around it so agents walk up to its edge.
+     */
+    bool setTargets( const std::vector<glm::vec3> & targets );
+
+    /**
+     * @brief Get which way to walk from a position.
+     * @param position Where the agent is; y is ignored.
+     * @param out_direction Where to store the unit XZ direction (y = 0).
+     * @return false if the position is off the grid, blocked, unreachable or
+     *         already at a target; walk straight there instead.
+     */
+    bool sample( const glm::vec3 & position, glm::vec3 & out_direction ) const;
+
+private:
+    /** @brief Cost stored for cells that can't reach any target. */
+    const static float UNREACHABLE;
+
+    /** @brief Index of a cell, or -1 if off the grid. */
+    int cellAt( const glm::vec3 & position ) const;
+
+    /** @brief Rebuild one target's integration field from scratch. */
+    void computeField( int targetCell, std::vector<float> & cost ) const;
+
+    /** @brief Rebuild m_cost and m_direction from the target fields. */
+    void combineFields();
+
+    /** @brief World XZ corner of cell (0, 0). */
+    glm::vec2 m_min;
+    int m_width;
+    int m_depth;
+    float m_cellSize;
+    /** @brief Whether each cell can be walked through; row major, X fastest. */
+    std::vector<bool> m_blocked;
+    /** @brief Path cost from each cell to each target; one per m_targetCells. */
+    std::vector<std::vector<float> > m_targetCost;
+    /** @brief Path cost from each cell to the nearest target. */
+    std::vector<float> m_cost;
+    /** @brief Unit XZ direction to walk from each cell; zero for none. */
+    std::vector<glm::vec2> m_direction;
+    /** @brief Cells the targets were in when the field was computed. */
+    std::vector<int> m_targetCells;
+    /** @brief Set when blocking changed since the field was computed. */
+    bool m_dirty;
+};
@@ -0,0 +1,206 @@
+#include "FramePacer.hpp"
+
+#include <cstdio>
+
+// How long before a frame is due the limiter stops sleeping and spins.
+// Sleeps can overshoot by a millisecond or two on most systems.
+static const double SPIN_SECONDS = 0.002;
+// Longest a fence is waited on before giving up on it, in nanoseconds
+static const GLuint64 FENCE_TIMEOUT = 1000000000;
+
+FramePacer::FramePacer():
+    m_swapInterval(1),
+    m_maxFramesInFlight(2),
+    m_frameLimit(0),
+    m_frameStart( SDL_GetPerformanceCounter() ),
+    m_nextFrame(0),
+    m_lastFrame(0.f),
+    m_appliedSwapInterval(-2),
+    m_fences(),
+    m_historyMutex(),
+    m_history()
+{
+    // nothing else to do
+}
+
+void
+FramePacer::setSwapInterval( int interval )
+{
+    m_swapInterval = interval;
+}
+
+int
+FramePacer::getSwapInterval()
+const {
+    return m_swapInterval;
+}
+
+void
+FramePacer::setMaxFramesInFlight( int frames )
+{
+    m_maxFramesInFlight = frames < 1 ? 1 : frames;
+}
+
+int
+FramePacer::getMaxFramesInFlight()
+const {
+    return m_maxFramesInFlight;
+}
+
+void
+FramePacer::setFrameLimit( int fps )
+{
+    m_frameLimit = fps < 0 ? 0 : fps;
+}
+
+int
+FramePacer::getFrameLimit()
+const {
+    return m_frameLimit;
+}
+
+void
+FramePacer::beginFrame()
+{
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    int limit = m_frameLimit;
+
+    if ( limit > 0 ) {
+        Uint64 period = frequency / limit;
+        Uint64 now = SDL_GetPerformanceCounter();
+
+        // Aim for one period after the last frame was due, not after it
+        // actually started, so small overshoots don't add up. If we're a
+        // whole frame behind there's no catching up, so start over from now.
+        if ( m_nextFrame == 0 || now > m_nextFrame + period ) {
+            m_nextFrame = now;
+        }
+
+        // Sleep in whole milliseconds while there's plenty of time left...
+        Uint64 spin = (Uint64)( SPIN_SECONDS * frequency );
+        while ( now + spin < m_nextFrame ) {
+            Uint32 ms = (Uint32)( ( m_nextFrame - spin - now ) * 1000 / frequency );
+            SDL_Delay( ms > 0 ? ms : 1 );
+            now = SDL_GetPerformanceCounter();
+        }
+
+        // ...then spin for the rest, which is exact
+        while ( now < m_nextFrame ) {
+            now = SDL_GetPerformanceCounter();
+        }
+
+        m_nextFrame += period;
+    } else {
+        m_nextFrame = 0;
+    }
+
+    Uint64 now = SDL_GetPerformanceCounter();
+    m_lastFrame = getMilliseconds( m_frameStart, now );
+    m_frameStart = now;
+}
+
+float
+FramePacer::getCpuTime()
+const {
+    return getMilliseconds( m_frameStart, SDL_GetPerformanceCounter() );
+}
+
+float
+FramePacer::getLastFrameTime()
+const {
+    return m_lastFrame;
+}
+
+float
+FramePacer::waitForGpu()
+{
+    int interval = m_swapInterval;
+    if ( interval != m_appliedSwapInterval ) {
+        // Adaptive vsync isn't available everywhere; plain vsync is close
+        if ( SDL_GL_SetSwapInterval( interval ) != 0 && interval == -1 ) {
+            printf( "Adaptive vsync not supported, using vsync\n" );
+            SDL_GL_SetSwapInterval( 1 );
+        }
+        m_appliedSwapInterval = interval;
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    // Leave room for the frame about to be made
+    while ( (int)m_fences.size() >= m_maxFramesInFlight ) {
+        glClientWaitSync( m_fences.front(), GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT );
+        glDeleteSync( m_fences.front() );
+        m_fences.pop_front();
+    }
+
+    return getMilliseconds( start, SDL_GetPerformanceCounter() );
+}
+
+void
+FramePacer::endGpuFrame()
+{
+    m_fences.push_back( glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 ) );
+}
+
+void
+FramePacer::releaseGpu()
+{
+    for ( GLsync fence : m_fences ) {
+        glDeleteSync( fence );
+    }
+    m_fences.clear();
+}
+
+void
+FramePacer::addTimings( const FrameTimings & timings )
+{
+    std::lock_guard<std::mutex> lock( m_historyMutex );
+    m_history.push_back( timings );
+    if ( (int)m_history.size() > HISTORY_LENGTH ) m_history.pop_front();
+}
+
+FrameTimings
+FramePacer::getLastTimings()
+const {
+    std::lock_guard<std::mutex> lock( m_historyMutex );
+    FrameTimings last = {};
+    if ( !m_history.empty() ) last = m_history.back();
+    return last;
+}
+
+FrameTimings
+FramePacer::getAverageTimings()
+const {
+    std::lock_guard<std::mutex> lock( m_historyMutex );
+    FrameTimings sum = {};
+    for ( const FrameTimings & t : m_history ) {
+        sum.cpu += t.cpu;
+        sum.gpuWait += t.gpuWait;
+        sum.render += t.render;
+        sum.present += t.present;
+        sum.frame += t.frame;
+        sum.gpuScene += t.gpuScene;
+        sum.gpuPostProcess += t.gpuPostProcess;
+        sum.gpuGui += t.gpuGui;
+    }
+
+    if ( !m_history.empty() ) {
+        float n = m_history.size();
+        sum.cpu /= n;
+        sum.gpuWait /= n;
+        sum.render /= n;
+        sum.present /= n;
+        sum.frame /= n;
+        sum.gpuScene /= n;
+        sum.gpuPostProcess /= n;
+        sum.gpuGui /= n;
+    }
+    return sum;
+}
+
+float
+FramePacer::getMilliseconds( Uint64 start,
+                             Uint64 end )
+{
+    return ( end - start ) * 1000.0 / SDL_GetPerformanceFrequency();
+}
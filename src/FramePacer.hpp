@@ -0,0 +1,135 @@
+/**
+ * @file FramePacer.hpp
+ * @brief Interface for FramePacer
+ * @author Michael Hitchens
+ */
+
+#pragma once
+
+#include "OpenGLImport.hpp"
+
+#include <SDL.h>
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+
+/**
+ * @brief How long the parts of one frame took, in milliseconds.
+ */
+struct FrameTimings {
+    /** @brief Main thread: events, updates and making the snapshot. */
+    float cpu;
+    /** @brief Render thread blocked until the GPU caught up with old frames. */
+    float gpuWait;
+    /** @brief Render thread making OpenGL calls. */
+    float render;
+    /** @brief Inside SDL_GL_SwapWindow; long with vsync. */
+    float present;
+    /** @brief From the start of this frame on the main thread to the next. */
+    float frame;
+    /** @brief GPU time of each pass, from a few frames earlier; see GpuTimer. */
+    float gpuScene;
+    float gpuPostProcess;
+    float gpuGui;
+};
+
+/**
+ * @brief Keeps frames evenly spaced and the GPU from running far behind.
+ * @details Three knobs:
+ *          - swap interval: 0 for no vsync, 1 for vsync, -1 for adaptive
+ *            vsync where supported.
+ *          - frames in flight: how many frames the GPU may still be working
+ *            on before the renderer waits. Drivers queue a few frames by
+ *            default which adds that many frames of input lag; a fence after
+ *            every swap bounds it.
+ *          - frame limit: the main loop sleeps, then spins for the last bit,
+ *            so frames start exactly one period apart.
+ * @remark The limiter runs on the main thread; the fences and swap interval
+ *         belong to whichever thread owns the OpenGL context. Settings may be
+ *         changed from either.
+ */
+class FramePacer {
+public:
+    FramePacer();
+
+    void setSwapInterval( int interval );
+    int getSwapInterval() const;
+
+    /** @param frames At least 1. */
+    void setMaxFramesInFlight( int frames );
+    int getMaxFramesInFlight() const;
+
+    /** @param fps Frames per second to start at most; 0 for no limit. */
+    void setFrameLimit( int fps );
+    int getFrameLimit() const;
+
+    /**
+     * @brief Mark the start of a frame on the main thread.
+     * @remark Waits first so frames start no faster than the limit.
+     */
+    void beginFrame();
+
+    /** @brief Get how long the main thread has worked since beginFrame(). */
+    float getCpuTime() const;
+
+    /** @brief Get how long the frame before the current one took. */
+    float getLastFrameTime() const;
+
+    /**
+     * @brief Get ready to make OpenGL calls for a new frame.
+     * @details Applies a changed swap interval and waits for old frames to
+     *          finish on the GPU.
+     * @return Milliseconds spent waiting for the GPU.
+     * @remark Render thread only.
+     */
+    float waitForGpu();
+
+    /**
+     * @brief Mark the end of a frame's OpenGL calls, after the swap.
+     * @remark Render thread only.
+     */
+    void endGpuFrame();
+
+    /**
+     * @brief Delete any fences that are still waiting.
+     * @remark Call with the context current before it's destroyed.
+     */
+    void releaseGpu();
+
+    /** @brief Record the timings of a frame that has been shown. */
+    void addTimings( const FrameTimings & timings );
+
+    /** @brief Get the timings of the last frame shown. */
+    FrameTimings getLastTimings() const;
+
+    /** @brief Get the average timings over the last few frames. */
+    FrameTimings getAverageTimings() const;
+
+    /** @brief Get the milliseconds between two performance counter readings. */
+    static float getMilliseconds( Uint64 start, Uint64 end );
+
+private:
+    /** @brief Frames kept for getAverageTimings(). */
+    static const int HISTORY_LENGTH = 60;
+
+    std::atomic<int> m_swapInterval;
+    std::atomic<int> m_maxFramesInFlight;
+    std::atomic<int> m_frameLimit;
+
+    /** @brief When the current frame started, in performance counter ticks. */
+    Uint64 m_frameStart;
+    /** @brief When the next frame should start; 0 if not limiting. */
+    Uint64 m_nextFrame;
+    /** @brief Length of the last frame, for the next frame's timings. */
+    float m_lastFrame;
+
+    /** @brief Swap interval the context has now, -2 until first set; render thread only. */
+    int m_appliedSwapInterval;
+    /** @brief One fence per frame the GPU may still be working on. */
+    std::deque<GLsync> m_fences;
+
+    mutable std::mutex m_historyMutex;
+    /** @brief Timings of recent frames, oldest first. */
+    std::deque<FrameTimings> m_history;
+};
@@ -0,0 +1,48 @@
+#include "Frustum.hpp"
+
+Frustum::Frustum()
+{
+    // A plane with no normal and positive distance has everything inside
+    for ( int i = 0; i < 6; i++ ) {
+        m_planes[i] = glm::vec4( 0.f, 0.f, 0.f, 1.f );
+    }
+}
+
+Frustum::Frustum( const glm::mat4 & viewProjection )
+{
+    // glm is column major so row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+    const glm::mat4 & m = viewProjection;
+    glm::vec4 row0( m[0][0], m[1][0], m[2][0], m[3][0] );
+    glm::vec4 row1( m[0][1], m[1][1], m[2][1], m[3][1] );
+    glm::vec4 row2( m[0][2], m[1][2], m[2][2], m[3][2] );
+    glm::vec4 row3( m[0][3], m[1][3], m[2][3], m[3][3] );
+
+    m_planes[0] = row3 + row0; // left
+    m_planes[1] = row3 - row0; // right
+    m_planes[2] = row3 + row1; // bottom
+    m_planes[3] = row3 - row1; // top
+    m_planes[4] = row3 + row2; // near
+    m_planes[5] = row3 - row2; // far
+}
+
+bool
+Frustum::intersects( const glm::vec3 & bbMin,
+                     const glm::vec3 & bbMax )
+const {
+    for ( int i = 0; i < 6; i++ ) {
+        const glm::vec4 & p = m_planes[i];
+
+        // Test the corner furthest along the plane normal; if even that one
+        // is outside then the whole box is.
+        glm::vec3 corner(
+            p.x >= 0.f ? bbMax.x : bbMin.x,
+            p.y >= 0.f ? bbMax.y : bbMin.y,
+            p.z >= 0.f ? bbMax.z : bbMin.z );
+
+        if ( glm::dot( glm::vec3(p), corner ) + p.w < 0.f ) {
+            return false;
+        }
+    }
+
+    return true;
+}
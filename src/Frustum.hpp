@@ -0,0 +1,39 @@
+/**
+ * @file Frustum.hpp
+ * @brief Interface for Frustum
+ * @author Michael Hitchens
+ */
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+/**
+ * @brief The volume of the world that a camera can see.
+ * @details Stored as 6 planes pointing inwards. Planes are extracted straight
+ *          from a view-projection matrix (Gribb & Hartmann).
+ */
+class Frustum {
+public:
+    /** @brief Create a frustum that contains everything. */
+    Frustum();
+
+    /**
+     * @brief Create the frustum for a camera.
+     * @param viewProjection The camera projection matrix times view matrix.
+     */
+    explicit Frustum( const glm::mat4 & viewProjection );
+
+    /**
+     * @brief Determine whether a box is at least partially inside.
+     * @param bbMin The minimum corner of the axis-aligned box.
+     * @param bbMax The maximum corner of the axis-aligned box.
+     * @return true if potentially visible, false if definitely not.
+     * @remark Conservative: boxes near corners may be reported as visible.
+     */
+    bool intersects( const glm::vec3 & bbMin, const glm::vec3 & bbMax ) const;
+
+private:
+    /** @brief Plane equations (normal, distance); inside is positive. */
+    glm::vec4 m_planes[6];
+};
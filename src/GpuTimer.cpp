@@ -0,0 +1,97 @@
+#include "GpuTimer.hpp"
+
+#include <cstdio>
+
+GpuTimer::GpuTimer():
+    m_created(false),
+    m_supported(false),
+    m_frame(0),
+    m_queries(),
+    m_issued(),
+    m_milliseconds()
+{
+    // nothing else to do
+}
+
+void
+GpuTimer::beginFrame()
+{
+    if ( !m_created ) {
+        m_created = true;
+
+        // Drivers without a timer give it no bits rather than an error
+        GLint bits = 0;
+        glGetQueryiv( GL_TIME_ELAPSED, GL_QUERY_COUNTER_BITS, &bits );
+        m_supported = bits > 0;
+        if ( !m_supported ) {
+            printf( "GPU timer queries not supported\n" );
+            return;
+        }
+        glGenQueries( QUERY_FRAMES * PASS_COUNT, &m_queries[0][0] );
+    }
+    if ( !m_supported ) return;
+
+    m_frame = ( m_frame + 1 ) % QUERY_FRAMES;
+
+    for ( int pass = 0; pass < PASS_COUNT; pass++ ) {
+        if ( !m_issued[m_frame][pass] ) continue;
+        m_issued[m_frame][pass] = false;
+
+        // Should always be ready by now; if not, keep the old time
+        GLuint query = m_queries[m_frame][pass];
+        GLint available = 0;
+        glGetQueryObjectiv( query, GL_QUERY_RESULT_AVAILABLE, &available );
+        if ( !available ) continue;
+
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v( query, GL_QUERY_RESULT, &nanoseconds );
+        m_milliseconds[pass] = nanoseconds / 1e6f;
+    }
+}
+
+void
+GpuTimer::begin( Pass pass )
+{
+    if ( !m_supported ) return;
+    glBeginQuery( GL_TIME_ELAPSED, m_queries[m_frame][pass] );
+}
+
+void
+GpuTimer::end( Pass pass )
+{
+    if ( !m_supported ) return;
+    glEndQuery( GL_TIME_ELAPSED );
+    m_issued[m_frame][pass] = true;
+}
+
+float
+GpuTimer::getMilliseconds( Pass pass )
+const {
+    return m_milliseconds[pass];
+}
+
+const char *
+GpuTimer::getPassName( Pass pass )
+{
+    switch ( pass ) {
+        case SCENE: return "GPU scene";
+        case POSTPROCESS: return "GPU post process";
+        case GUI: return "GPU gui";
+        default: return "GPU";
+    }
+}
+
+void
+GpuTimer::releaseGpu()
+{
+    if ( m_created && m_supported ) {
+        glDeleteQueries( QUERY_FRAMES * PASS_COUNT, &m_queries[0][0] );
+    }
+    for ( int frame = 0; frame < QUERY_FRAMES; frame++ ) {
+        for ( int pass = 0; pass < PASS_COUNT; pass++ ) {
+            m_issued[frame][pass] = false;
+        }
+    }
+    m_created = false;
+    m_supported = false;
+}
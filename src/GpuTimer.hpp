@@ -0,0 +1,68 @@
+/**
+ * @file GpuTimer.hpp
+ * @brief Interface for GpuTimer
+ * @author Michael Hitchens
+ */
+
+#pragma once
+
+#include "OpenGLImport.hpp"
+
+/**
+ * @brief Measures how long the GPU spends on each pass of a frame.
+ * @details Each pass is wrapped in a GL_TIME_ELAPSED query. Asking for a
+ *          result before the GPU has finished would stall, so every frame
+ *          uses its own set of queries and a set is only read back when it
+ *          comes round to be reused, by which time the frame pacer has waited
+ *          for that frame to finish. Results are therefore a few frames old.
+ * @remark Render thread only; all of it needs the context current. Reports 0
+ *         where timer queries aren't supported.
+ */
+class GpuTimer {
+public:
+    enum Pass {
+        SCENE,
+        POSTPROCESS,
+        GUI,
+        PASS_COUNT
+    };
+
+    GpuTimer();
+
+    /**
+     * @brief Start timing a new frame.
+     * @details Makes the queries the first time, then reads back the oldest
+     *          frame's results so its queries can be reused.
+     */
+    void beginFrame();
+
+    /** @remark Passes may not overlap. */
+    void begin( Pass pass );
+    void end( Pass pass );
+
+    /** @brief Get the most recent GPU time of a pass, in milliseconds. */
+    float getMilliseconds( Pass pass ) const;
+
+    static const char * getPassName( Pass pass );
+
+    /**
+     * @brief Delete the queries.
+     * @remark Call with the context current before it's destroyed.
+     */
+    void releaseGpu();
+
+private:
+    /** @brief Sets of queries; more than the frame pacer allows in flight. */
+    static const int QUERY_FRAMES = 4;
+
+    /** @brief Whether the queries have been made yet. */
+    bool m_created;
+    /** @brief Whether the driver can time anything. */
+    bool m_supported;
+    /** @brief Set of queries the current frame uses. */
+    int m_frame;
+    GLuint m_queries[QUERY_FRAMES][PASS_COUNT];
+    /** @brief Whether each query was used in its frame, so has a result. */
+    bool m_issued[QUERY_FRAMES][PASS_COUNT];
+    float m_milliseconds[PASS_COUNT];
+};
@@ -0,0 +1,167 @@
+#include "InputRecording.hpp"
+
+#include <cstring>
+
+// Start of every recording, then the format version
+static const char MAGIC[4] = { 'G', 'I', 'N', 'P' };
+static const unsigned char VERSION = 1;
+// Bytes per update
+static const int TICK_SIZE = 5;
+
+/** @brief Keep mouse movement within 16 bits. */
+static int
+clampLook( int pixels )
+{
+    if ( pixels > 32767 ) return 32767;
+    if ( pixels < -32768 ) return -32768;
+    return pixels;
+}
+
+/** @brief Read a little endian 16 bit integer. */
+static int
+readInt16( const unsigned char * bytes )
+{
+    return (short)( bytes[0] | ( bytes[1] << 8 ) );
+}
+
+InputRecording::InputRecording():
+    m_file(nullptr),
+    m_seed(0),
+    m_ticks(),
+    m_tick(0)
+{
+    // nothing else to do
+}
+
+InputRecording::~InputRecording()
+{
+    stopRecording();
+}
+
+bool
+InputRecording::startRecording( const std::string & filename,
+                                unsigned seed )
+{
+    stopRecording();
+
+    m_file = fopen( filename.c_str(), "wb" );
+    if ( m_file == nullptr ) {
+        printf( "Couldn't open %s to record input\n", filename.c_str() );
+        return false;
+    }
+
+    unsigned char header[9];
+    memcpy( header, MAGIC, 4 );
+    header[4] = VERSION;
+    for ( int i = 0; i < 4; i++ ) {
+        header[5 + i] = ( seed >> ( 8 * i ) ) & 0xFF;
+    }
+    fwrite( header, 1, sizeof( header ), m_file );
+
+    m_seed = seed;
+    m_tick = 0;
+    printf( "Recording input to %s\n", filename.c_str() );
+    return true;
+}
+
+void
+InputRecording::record( const TickInput & input )
+{
+    if ( m_file == nullptr ) return;
+
+    int x = clampLook( input.look.x );
+    int y = clampLook( input.look.y );
+    unsigned char bytes[TICK_SIZE] = {
+        input.buttons,
+        (unsigned char)( x & 0xFF ), (unsigned char)( ( x >> 8 ) & 0xFF ),
+        (unsigned char)( y & 0xFF ), (unsigned char)( ( y >> 8 ) & 0xFF )
+    };
+    fwrite( bytes, 1, TICK_SIZE, m_file );
+    m_tick++;
+}
+
+void
+InputRecording::stopRecording()
+{
+    if ( m_file == nullptr ) return;
+
+    fclose( m_file );
+    m_file = nullptr;
+    printf( "Recorded %d updates\n", m_tick );
+}
+
+bool
+InputRecording::isRecording()
+const {
+    return m_file != nullptr;
+}
+
+bool
+InputRecording::load( const std::string & filename )
+{
+    FILE * file = fopen( filename.c_str(), "rb" );
+    if ( file == nullptr ) {
+        printf( "Couldn't open recording %s\n", filename.c_str() );
+        return false;
+    }
+
+    unsigned char header[9];
+    if ( fread( header, 1, sizeof( header ), file ) != sizeof( header ) ||
+         memcmp( header, MAGIC, 4 ) != 0 || header[4] != VERSION ) {
+        printf( "%s isn't an input recording\n", filename.c_str() );
+        fclose( file );
+        return false;
+    }
+
+    m_seed = 0;
+    for ( int i = 0; i < 4; i++ ) {
+        m_seed |= (unsigned)header[5 + i] << ( 8 * i );
+    }
+
+    m_ticks.clear();
+    unsigned char bytes[TICK_SIZE];
+    while ( fread( bytes, 1, TICK_SIZE, file ) == TICK_SIZE ) {
+        TickInput input;
+        input.buttons = bytes[0];
+        input.look = glm::ivec2( readInt16( bytes + 1 ), readInt16( bytes + 3 ) );
+        m_ticks.push_back( input );
+    }
+    fclose( file );
+
+    m_tick = 0;
+    printf( "Loaded %d updates from %s\n", (int)m_ticks.size(), filename.c_str() );
+    return true;
+}
+
+bool
+InputRecording::isReplaying()
+const {
+    return m_tick < (int)m_ticks.size();
+}
+
+bool
+InputRecording::next( TickInput & out )
+{
+    if ( !isReplaying() ) return false;
+
+    out = m_ticks[m_tick++];
+    return true;
+}
+
+unsigned
+InputRecording::getSeed()
+const {
+    return m_seed;
+}
+
+int
+InputRecording::getTick()
+const {
+    return m_tick;
+}
+
+int
+InputRecording::getTickCount()
+const {
+    return m_ticks.size();
+}
@@ -0,0 +1,100 @@
+/**
+ * @file InputRecording.hpp
+ * @brief Interface for InputRecording
+ * @author Michael Hitchens
+ */
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/** @brief Bits of TickInput::buttons. */
+enum InputButton {
+    INPUT_FORWARD = 1 << 0,
+    INPUT_BACK    = 1 << 1,
+    INPUT_LEFT    = 1 << 2,
+    INPUT_RIGHT   = 1 << 3,
+    INPUT_JUMP    = 1 << 4,
+    INPUT_FIRE    = 1 << 5,
+    /** @brief Playing rather than paused. */
+    INPUT_CAPTURE = 1 << 6,
+    INPUT_CHEATS  = 1 << 7
+};
+
+/**
+ * @brief Everything the player did that one update depends on.
+ */
+struct TickInput {
+    /** @brief InputButton bits. */
+    unsigned char buttons;
+    /** @brief Mouse movement to turn by, in pixels. */
+    glm::ivec2 look;
+};
+
+/**
+ * @brief Saves the input of every update of a game, or plays it back.
+ * @details Along with the seed rand() was given when the game started, the
+ *          input is all a game needs to play out the same way again. The
+ *          file is a header and then 5 bytes per update, little endian:
+ *          buttons, then the look x and y as 16 bit integers.
+ * @remark Only reproduces a game if the build runs the same code the same
+ *         way, which is what replays are for checking.
+ */
+class InputRecording {
+public:
+    InputRecording();
+
+    /** @brief Closes a recording in progress. */
+    ~InputRecording();
+
+    /**
+     * @brief Start writing updates to a file.
+     * @return False if the file can't be opened.
+     */
+    bool startRecording( const std::string & filename, unsigned seed );
+
+    /** @brief Write one update's input. */
+    void record( const TickInput & input );
+
+    /** @brief Finish the file. */
+    void stopRecording();
+
+    bool isRecording() const;
+
+    /**
+     * @brief Read a recording to play back.
+     * @return False if the file can't be read or isn't a recording.
+     */
+    bool load( const std::string & filename );
+
+    /** @brief Get whether there's input left to play back. */
+    bool isReplaying() const;
+
+    /**
+     * @brief Get the next update's input.
+     * @return False once every update has been played back.
+     */
+    bool next( TickInput & out );
+
+    /** @brief Get the seed of the recording being written or played. */
+    unsigned getSeed() const;
+
+    /** @brief Get how many updates have been written or played back. */
+    int getTick() const;
+
+    int getTickCount() const;
+
+private:
+    InputRecording( const InputRecording & );
+    InputRecording & operator=( const InputRecording & );
+
+    FILE * m_file;
+    unsigned m_seed;
+    /** @brief Input being played back. */
+    std::vector<TickInput> m_ticks;
+    int m_tick;
+};
@@ -0,0 +1,203 @@
+#include "JobSystem.hpp"
+
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+// The game thread runs jobs too, so one worker per remaining core up to this
+static const int MAX_WORKERS = 15;
+
+// Queue of the current thread; workers set this when they start
+static thread_local int t_queueIndex = 0;
+
+JobSystem * JobSystem::instance = nullptr;
+
+JobSystem::Counter::Counter():
+    m_pending(0)
+{
+    // nothing else to do
+}
+
+bool
+JobSystem::Counter::done()
+const {
+    return m_pending.load( std::memory_order_acquire ) == 0;
+}
+
+JobSystem *
+JobSystem::getInstance()
+{
+    if ( instance == nullptr ) instance = new JobSystem();
+    return instance;
+}
+
+void
+JobSystem::cleanup()
+{
+    delete instance;
+    instance = nullptr;
+}
+
+JobSystem::JobSystem():
+    m_queues(),
+    m_workers(),
+    m_queued(0),
+    m_quit(false),
+    m_sleepMutex(),
+    m_wake()
+{
+    int cores = std::thread::hardware_concurrency();
+    int workers = std::min( std::max( cores - 1, 0 ), MAX_WORKERS );
+
+    for ( int i = 0; i <= workers; i++ ) {
+        m_queues.push_back( std::unique_ptr<Queue>( new Queue() ) );
+    }
+    for ( int i = 1; i <= workers; i++ ) {
+        m_workers.push_back( std::thread( &JobSystem::workerLoop, this, i ) );
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_sleepMutex );
+        m_quit = true;
+    }
+    m_wake.notify_all();
+
+    for ( std::thread & worker : m_workers ) {
+        worker.join();
+    }
+}
+
+void
+JobSystem::run( const Job & job,
+                Counter & counter )
+{
+    counter.m_pending.fetch_add( 1, std::memory_order_relaxed );
+
+    Task task = { job, &counter };
+    Queue & queue = *m_queues[getThreadIndex()];
+    {
+        std::lock_guard<std::mutex> lock( queue.mutex );
+        queue.tasks.push_back( task );
+    }
+    m_queued.fetch_add( 1 );
+
+    // Taking the lock means a worker can't miss this between checking for
+    // work and going to sleep
+    {
+        std::lock_guard<std::mutex> lock( m_sleepMutex );
+    }
+    m_wake.notify_one();
+}
+
+void
+JobSystem::wait( Counter & counter )
+{
+    int self = getThreadIndex();
+    while ( !counter.done() ) {
+        // Our jobs may have been stolen and still be running elsewhere
+        if ( !runOne( self ) ) std::this_thread::yield();
+    }
+}
+
+void
+JobSystem::parallelFor( int count,
+                        int grainSize,
+                        const std::function<void( int, int )> & body )
+{
+    if ( count <= 0 ) return;
+    grainSize = std::max( grainSize, 1 );
+
+    if ( count <= grainSize || m_workers.empty() ) {
+        body( 0, count );
+        return;
+    }
+
+    Counter counter;
+    for ( int begin = 0; begin < count; begin += grainSize ) {
+        int end = std::min( begin + grainSize, count );
+        run( [&body, begin, end]() { body( begin, end ); }, counter );
+    }
+    wait( counter );
+}
+
+int
+JobSystem::getThreadCount()
+const {
+    return m_workers.size() + 1;
+}
+
+int
+JobSystem::getThreadIndex()
+const {
+    return t_queueIndex;
+}
+
+bool
+JobSystem::takeTask( int self,
+                     Task & out_task )
+{
+    if ( m_queued.load() == 0 ) return false;
+
+    // Newest of our own first
+    {
+        Queue & queue = *m_queues[self];
+        std::lock_guard<std::mutex> lock( queue.mutex );
+        if ( !queue.tasks.empty() ) {
+            out_task = queue.tasks.back();
+            queue.tasks.pop_back();
+            m_queued.fetch_sub( 1 );
+            return true;
+        }
+    }
+
+    // Then the oldest of someone else's, which tend to be the biggest
+    int queueCount = m_queues.size();
+    for ( int i = 1; i < queueCount; i++ ) {
+        Queue & queue = *m_queues[( self + i ) % queueCount];
+        std::lock_guard<std::mutex> lock( queue.mutex );
+        if ( !queue.tasks.empty() ) {
+            out_task = queue.tasks.front();
+            queue.tasks.pop_front();
+            m_queued.fetch_sub( 1 );
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool
+JobSystem::runOne( int self )
+{
+    Task task;
+    if ( !takeTask( self, task ) ) return false;
+
+    {
+        PROFILE_SCOPE( "Job" );
+        task.job();
+    }
+    task.counter->m_pending.fetch_sub( 1, std::memory_order_release );
+    return true;
+}
+
+void
+JobSystem::workerLoop( int index )
+{
+    t_queueIndex = index;
+
+    char name[32];
+    snprintf( name, 32, "Worker %d", index );
+    Profiler::getInstance()->setThreadName( name );
+
+    while ( true ) {
+        if ( runOne( index ) ) continue;
+
+        std::unique_lock<std::mutex> lock( m_sleepMutex );
+        m_wake.wait( lock, [this]() { return m_quit || m_queued.load() > 0; } );
+        if ( m_quit && m_queued.load() == 0 ) return;
+    }
+}
@@ -0,0 +1,129 @@
+/**
+ * @file JobSystem.hpp
+ * @brief Interface for JobSystem
+ * @author Michael Hitchens
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Runs small jobs on a pool of worker threads.
+ * @details Every thread has its own queue. New jobs go on the back of the
+ *          submitting thread's queue and it takes work from the back too, so
+ *          recently made (cache-warm) jobs run first. Idle threads steal from
+ *          the front of other queues.
+ * @details A thread that waits for jobs runs queued jobs in the meantime
+ *          instead of blocking, so jobs may start and wait on more jobs.
+ * @remark Jobs must not throw and must not touch OpenGL or call rand(); keep
+ *         those on the main thread.
+ * @remark Singleton!
+ */
+class JobSystem {
+public:
+    typedef std::function<void()> Job;
+
+    /**
+     * @brief Counts unfinished jobs so something can wait for all of them.
+     * @remark Must outlive every job started with it.
+     */
+    class Counter {
+    public:
+        Counter();
+
+        /** @brief Get whether every job counted here has finished. */
+        bool done() const;
+
+    private:
+        friend class JobSystem;
+        std::atomic<int> m_pending;
+    };
+
+    /**
+     * @brief Get the singleton instance.
+     * @remark Lazy inits the instance, which starts the worker threads.
+     */
+    static JobSystem * getInstance();
+
+    /** @brief Stop the workers and delete the singleton instance. */
+    static void cleanup();
+
+    /**
+     * @brief Queue a job.
+     * @param job What to run.
+     * @param counter Counts the job until it has finished.
+     */
+    void run( const Job & job, Counter & counter );
+
+    /** @brief Run queued jobs until every job on a counter has finished. */
+    void wait( Counter & counter );
+
+    /**
+     * @brief Call body over [0, count) in chunks, spread over all threads.
+     * @param count Number of iterations.
+     * @param grainSize Iterations per chunk.
+     * @param body Called as body( begin, end ) once per chunk.
+     * @details Returns once every chunk has finished. Chunks only depend on
+     *          count and grainSize, never on the number of threads, so a body
+     *          that writes only to its own iterations gives the same results
+     *          on any machine.
+     * @remark Small loops of one chunk run right here with no overhead.
+     */
+    void parallelFor( int count, int grainSize, const std::function<void( int, int )> & body );
+
+    /** @brief Get the number of threads running jobs, including the caller. */
+    int getThreadCount() const;
+
+    /**
+     * @brief Get the index of the calling thread, in [0, getThreadCount()).
+     * @remark Every thread outside the pool is 0, so only one of them should
+     *         use this to pick per-thread storage.
+     */
+    int getThreadIndex() const;
+
+private:
+    static JobSystem * instance;
+
+    struct Task {
+        Job job;
+        Counter * counter;
+    };
+
+    /** @brief One thread's jobs. */
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    JobSystem();
+
+    /** @brief Stops and joins the workers; queued jobs are finished first. */
+    ~JobSystem();
+
+
+    /** @brief Take a job from our own queue or steal one from another. */
+    bool takeTask( int self, Task & out_task );
+
+    /** @brief Run one queued job if there is any. */
+    bool runOne( int self );
+
+    void workerLoop( int index );
+
+    /** @brief Queue 0 is shared by every thread outside the pool. */
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_workers;
+    /** @brief Jobs queued but not yet taken, over all queues. */
+    std::atomic<int> m_queued;
+    std::atomic<bool> m_quit;
+    /** @brief Workers sleep on m_wake when there's nothing to do. */
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+};
@@ -1,14 +1,17 @@
 #include "Level.hpp"
 
 #include "SceneNode.hpp"
-#include "GeometryNode.hpp"
-#include "Shader.hpp"
+#include "StaticGeometry.hpp"
+#include "RenderSnapshot.hpp"
 #include "Enemy.hpp"
-#include "Bullet.hpp"
 #include "ParticleSystem.hpp"
+#include "Systems.hpp"
+#include "JobSystem.hpp"
 #include "Player.hpp"
 #include "TextureCache.hpp"
 #include "ModelCache.hpp"
+#include "Profiler.hpp"
+#include "Checksum.hpp"
 #include "Keyframe.hpp"
 #include "Model.hpp"
 #include <glm/glm.hpp>
@@ -17,65 +20,143 @@
 #include "SoundCache.hpp"
 #include "globals.hpp"
 
-// defined in main.cpp
-extern Shader * shader;
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+// Iterations per job when update work is split over threads
+static const int CULL_GRAIN = 64;
+static const int DRAW_GRAIN = 64;
+static const int SWEEP_GRAIN = 32;
+static const int RAY_GRAIN = 64;
+
+/** @brief Get the bucket index of a CollisionLayer bit. */
+static int
+layerIndex( unsigned layer )
+{
+    int index = 0;
+    while ( layer > 1u ) {
+        layer >>= 1;
+        index++;
+    }
+    return index;
+}
 
 Level::Level():
+    m_arena(),
     m_lights(),
-    m_scene_root(nullptr),
-    m_scene_particle_systems(nullptr),
-    m_scene_enemies(nullptr),
-    m_scene_bullets(nullptr),
-    m_cake(nullptr)
+    m_cake(nullptr),
+    m_static(),
+    m_animated(),
+    m_frustum(),
+    m_world(),
+    m_packets(),
+    m_layers(),
+    m_unmergedStaticBoxes(0),
+    m_enemyCollidersDirty(false),
+    m_flowField(),
+    m_flowTargets(),
+    m_blockedFlowCells(0),
+    m_crowd(),
+    m_aiFrame(0)
 {
-    m_scene_root = new SceneNode( "root" );
-
-    // a pseudo object under which bullets are kept
-    m_scene_bullets = new SceneNode( "bullets" );
-    m_scene_root->add_child( m_scene_bullets );
-
-    // all static scene geometry is in scene_static
-    m_scene_static = new SceneNode( "static" );
-    m_scene_root->add_child( m_scene_static );
-
-    // all enemies are in scene_enemies
-    m_scene_enemies = new SceneNode( "enemies" );
-    m_scene_root->add_child( m_scene_enemies );
-
-    // all particle systems are in scene_particle_systems
-    // Add last so it's the last thing drawn
-    // So alpha transparency works properly
-    m_scene_particle_systems = new SceneNode( "particle_systems" );
-    m_scene_root->add_child( m_scene_particle_systems );
+    // nothing else to do
 }
 
 Level::~Level()
 {
-    delete m_scene_root;
+    clear();
 }
 
 void
-Level::addStaticGeometry( GeometryNode * node )
+Level::clear()
 {
-    m_scene_static->add_child( node );
+    // Static geometry belongs to the arena and has nothing to destroy, so
+    // forgetting the pointers and resetting the arena releases it in one go.
+    m_static.clear();
+    m_animated.clear();
+    for ( LayerBucket & bucket : m_layers ) {
+        bucket.boxes.clear();
+        bucket.bvh.clear();
+    }
+    m_unmergedStaticBoxes = 0;
+    m_arena.reset();
+    m_cake = nullptr;
+    m_flowField.clear();
+    m_flowTargets.clear();
+    m_blockedFlowCells = 0;
+
+    // Enemies are entities too, so they go with the world
+    m_world.clear();
+    m_enemyCollidersDirty = false;
+
+    m_lights.clear();
 }
 
-void
-Level::addEnemy( Enemy * enemy )
+StaticGeometry *
+Level::addStaticGeometry( Model * prim,
+                          Material * mat,
+                          unsigned layer )
 {
-    m_scene_enemies->add_child( enemy );
+    // Trivially destructible, so the arena keeps no finalizer for it
+    StaticGeometry * geometry = m_arena.make<StaticGeometry>( prim, mat, layer );
+    m_static.push_back( geometry );
+    if ( geometry->isAnimated() ) {
+        m_animated.push_back( geometry );
+    }
+    return geometry;
 }
 
-void
-Level::addBullet( Bullet * bullet )
+Entity
+Level::addEnemy( Model * prim,
+                 Material * mat,
+                 const glm::vec3 & position )
 {
-    m_scene_bullets->add_child( bullet );
+    Entity enemy = Enemy::create( m_world, prim, mat, position );
+
+    // Grab its box on the next query
+    m_enemyCollidersDirty = true;
+    return enemy;
 }
 
-void
-Level::addParticleSystem( ParticleSystem * psys )
+World &
+Level::getWorld()
 {
-    m_scene_particle_systems->add_child( psys );
+    return m_world;
+}
+
+void
+Level::getSceneStats( SceneStats & out )
+const {
+    out.staticGeometry = m_static.size();
+    out.animatedGeometry = m_animated.size();
+    out.staticBoxes = m_layers[layerIndex( LAYER_STATIC )].boxes.size();
+    out.unmergedStaticBoxes = m_unmergedStaticBoxes;
+    out.flowFieldWidth = m_flowField.getWidth();
+    out.flowFieldDepth = m_flowField.getDepth();
+    out.blockedFlowCells = m_blockedFlowCells;
+    out.entities = m_world.getEntityCount();
+    out.transforms = m_world.transforms.size();
+    out.velocities = m_world.velocities.size();
+    out.lifetimes = m_world.lifetimes.size();
+    out.healths = m_world.healths.size();
+    out.meshes = m_world.meshes.size();
+    out.colliders = m_world.colliders.size();
+    out.emitters = m_world.emitters.size();
+    out.animations = m_world.animations.size();
+    out.enemies = m_world.enemies.size();
+}
+
+std::uint64_t
+Level::getChecksum( std::uint64_t hash )
+const {
+    int count = m_world.getEntityCount();
+    hash = checksumBytes( hash, &count, sizeof( count ) );
+    for ( int i = 0; i < m_world.transforms.size(); i++ ) {
+        hash = checksumBytes( hash, &m_world.transforms[i].position, sizeof( glm::vec3 ) );
+    }
+    return hash;
 }
 
 void
@@ -84,174 +165,551 @@ Level::addLight( const Light & light )
     m_lights.push_back( light );
 }
 
-GeometryNode *
-Level::findStaticCollision( SceneNode & other )
+bool
+Level::findCakeCollision( const AABB & box )
 {
-    return (GeometryNode*)m_scene_static->isCollidingWith( other );
+    return findInLayer( layerIndex( LAYER_CAKE ), box ) != nullptr;
 }
 
-Enemy *
-Level::findEnemyCollision( SceneNode & other )
+const CollisionBox *
+Level::findInLayer( int index,
+                    const AABB & query )
 {
-    return (Enemy*)m_scene_enemies->isCollidingWith( other );
+    const LayerBucket & bucket = m_layers[index];
+
+    int hit = bucket.bvh.findOverlap( query );
+    if ( hit < 0 ) return nullptr;
+    if ( isSolid( bucket.boxes[hit] ) ) return &bucket.boxes[hit];
+
+    // Something can stop being solid (dying enemies) between rebuilds; look
+    // past it
+    std::vector<int> hits;
+    bucket.bvh.findOverlaps( query, hits );
+    for ( int i : hits ) {
+        if ( isSolid( bucket.boxes[i] ) ) return &bucket.boxes[i];
+    }
+    return nullptr;
+}
+
+bool
+Level::isSolid( const CollisionBox & cb )
+const {
+    return cb.entity == NULL_ENTITY || m_world.colliders.has( cb.entity );
 }
 
-SceneNode *
-Level::findCakeCollision( SceneNode & other )
+bool
+Level::raycast( const glm::vec3 & origin,
+                const glm::vec3 & direction,
+                float maxDistance,
+                unsigned mask,
+                RayHit & out_hit )
 {
-    if ( m_cake ) {
-        return m_cake->isCollidingWith( other );
-    } else {
-        return nullptr;
+    out_hit.layer = LAYER_NONE;
+    out_hit.entity = NULL_ENTITY;
+    out_hit.box = AABB();
+    out_hit.distance = maxDistance;
+    out_hit.normal = glm::vec3( 0.f );
+    out_hit.point = origin;
+
+    float length = glm::length( direction );
+    if ( length == 0.f ) return false;
+
+    if ( mask & LAYER_ENEMY ) refreshEnemyColliders();
+
+    // Unit direction so t along the ray is a world distance
+    Ray ray( origin, direction / length );
+    for ( int i = 0; i < COLLISION_LAYER_COUNT; i++ ) {
+        if ( !( mask & ( 1u << i ) ) ) continue;
+
+        RayHit hit;
+        if ( castInLayer( i, ray, out_hit.distance, hit ) && ( out_hit.layer == LAYER_NONE || hit.distance < out_hit.distance ) ) {
+            out_hit = hit;
+        }
     }
+
+    return out_hit.layer != LAYER_NONE;
 }
 
-SceneNode *
-Level::findCollisionWith( SceneNode & other )
+void
+Level::raycastMany( const std::vector<glm::vec3> & origins,
+                    const std::vector<glm::vec3> & directions,
+                    float maxDistance,
+                    unsigned mask,
+                    std::vector<RayHit> & out_hits )
 {
-    SceneNode * collision;
-    if ( collision = findStaticCollision( other ) ) {
-        return collision;
-    }
+    out_hits.resize( origins.size() );
+    if ( origins.empty() ) return;
+
+    if ( mask & LAYER_ENEMY ) refreshEnemyColliders();
+
+    // Each job casts its share of the rays down each layer tree together and
+    // only writes the results of its own rays. Closest hit wins; ties go to
+    // the lower layer, same as raycast().
+    JobSystem::getInstance()->parallelFor( origins.size(), RAY_GRAIN, [&]( int begin, int end ) {
+        std::vector<Ray> rays;
+        std::vector<int> rayIndex;
+        rays.reserve( end - begin );
+        rayIndex.reserve( end - begin );
+        for ( int i = begin; i < end; i++ ) {
+            RayHit & out = out_hits[i];
+            out.layer = LAYER_NONE;
+            out.entity = NULL_ENTITY;
+            out.box = AABB();
+            out.distance = maxDistance;
+            out.normal = glm::vec3( 0.f );
+            out.point = origins[i];
+
+            float length = glm::length( directions[i] );
+            if ( length == 0.f ) continue;
+            rays.push_back( Ray( origins[i], directions[i] / length ) );
+            rayIndex.push_back( i );
+        }
+
+        std::vector<BVHHit> hits;
+        for ( int layer = 0; layer < COLLISION_LAYER_COUNT; layer++ ) {
+            if ( !( mask & ( 1u << layer ) ) ) continue;
+
+            m_layers[layer].bvh.raycastMany( rays, maxDistance, hits );
+            for ( std::size_t k = 0; k < rays.size(); k++ ) {
+                if ( hits[k].item < 0 ) continue;
 
-    if ( collision = findEnemyCollision( other ) ) {
-        return collision;
+                RayHit hit;
+                RayHit & best = out_hits[rayIndex[k]];
+                if ( resolveLayerHit( layer, rays[k], maxDistance, hits[k], hit ) && ( best.layer == LAYER_NONE || hit.distance < best.distance ) ) {
+                    best = hit;
+                }
+            }
+        }
+    });
+}
+
+bool
+Level::hasLineOfSight( const glm::vec3 & from,
+                       const glm::vec3 & to,
+                       unsigned mask )
+{
+    RayHit hit;
+    return !raycast( from, to - from, glm::length( to - from ), mask, hit );
+}
+
+bool
+Level::castInLayer( int index,
+                    const Ray & ray,
+                    float maxDistance,
+                    RayHit & out_hit )
+{
+    BVHHit hit;
+    if ( !m_layers[index].bvh.raycast( ray, maxDistance, hit ) ) return false;
+
+    return resolveLayerHit( index, ray, maxDistance, hit, out_hit );
+}
+
+bool
+Level::resolveLayerHit( int index,
+                        const Ray & ray,
+                        float maxDistance,
+                        BVHHit hit,
+                        RayHit & out_hit )
+const {
+    const LayerBucket & bucket = m_layers[index];
+
+    if ( !isSolid( bucket.boxes[hit.item] ) ) {
+        // Something stopped being solid (dying enemies) since the bucket was
+        // built; rare enough that checking every box is fine.
+        bool found = false;
+        for ( std::size_t i = 0; i < bucket.boxes.size(); i++ ) {
+            float t;
+            glm::vec3 normal;
+            if ( isSolid( bucket.boxes[i] ) &&
+                 intersectRayAABB( ray, bucket.boxes[i].box, maxDistance, t, normal ) &&
+                 ( !found || t < hit.t ) ) {
+                hit.item = i;
+                hit.t = t;
+                hit.normal = normal;
+                found = true;
+            }
+        }
+        if ( !found ) return false;
     }
 
-    if ( collision = findCakeCollision( other ) ) {
-        return collision;
+    out_hit.layer = bucket.boxes[hit.item].layer;
+    out_hit.entity = bucket.boxes[hit.item].entity;
+    out_hit.box = bucket.boxes[hit.item].box;
+    out_hit.distance = hit.t;
+    out_hit.normal = hit.normal;
+    out_hit.point = ray.origin + ray.direction * hit.t;
+    return true;
+}
+
+void
+Level::findCandidates( const AABB & region,
+                       unsigned mask,
+                       std::vector<CollisionBox> & out )
+{
+    if ( mask & LAYER_ENEMY ) refreshEnemyColliders();
+
+    std::vector<int> hits;
+    for ( int i = 0; i < COLLISION_LAYER_COUNT; i++ ) {
+        if ( !( mask & ( 1u << i ) ) ) continue;
+
+        hits.clear();
+        m_layers[i].bvh.findOverlaps( region, hits );
+        for ( int hit : hits ) {
+            if ( isSolid( m_layers[i].boxes[hit] ) ) out.push_back( m_layers[i].boxes[hit] );
+        }
     }
+}
 
-    // don't collide with bullets or particle systems
+bool
+Level::sweep( const AABB & moving,
+              const glm::vec3 & delta,
+              unsigned mask,
+              SweepHit & out_hit )
+{
+    std::vector<AABB> movingList( 1, moving );
+    std::vector<glm::vec3> deltaList( 1, delta );
+    std::vector<SweepHit> hits;
+    sweepMany( movingList, deltaList, mask, hits );
 
-    return nullptr;
+    out_hit = hits[0];
+    return out_hit.layer != LAYER_NONE;
 }
 
 void
-Level::draw( Shader * shader )
+Level::sweepMany( const std::vector<AABB> & moving,
+                  const std::vector<glm::vec3> & deltas,
+                  unsigned mask,
+                  std::vector<SweepHit> & out_hits )
 {
-    updateLightUniforms( shader );
-    m_scene_root->draw( glm::mat4( 1.f ) );
+    SweepHit none = { LAYER_NONE, NULL_ENTITY, AABB(), 1.f, glm::vec3( 0.f ) };
+    out_hits.assign( moving.size(), none );
+    if ( moving.empty() ) return;
+
+    if ( mask & LAYER_ENEMY ) refreshEnemyColliders();
+
+    // Earliest hit wins. Ties go to the lower layer, then the lower box
+    // index, so the result doesn't depend on how the trees were built or
+    // how the boxes are split between jobs.
+    std::vector<int> hitLayer( moving.size(), -1 );
+    std::vector<int> hitItem( moving.size(), -1 );
+
+    // Each job only reads the buckets and writes the results of its own
+    // boxes
+    JobSystem::getInstance()->parallelFor( moving.size(), SWEEP_GRAIN, [&]( int begin, int end ) {
+        // Broadphase on the volume each box passes through, then the exact
+        // sweep on whatever that turns up.
+        std::vector<AABB> swept;
+        swept.reserve( end - begin );
+        for ( int i = begin; i < end; i++ ) {
+            swept.push_back( moving[i].swept( deltas[i] ) );
+        }
+
+        std::vector<BVHPair> pairs;
+        for ( int layer = 0; layer < COLLISION_LAYER_COUNT; layer++ ) {
+            if ( !( mask & ( 1u << layer ) ) ) continue;
+            const LayerBucket & bucket = m_layers[layer];
+
+            pairs.clear();
+            bucket.bvh.findOverlapsMany( swept, pairs );
+            for ( const BVHPair & pair : pairs ) {
+                int q = begin + pair.query;
+                const CollisionBox & cb = bucket.boxes[pair.item];
+                if ( !isSolid( cb ) ) continue;
+
+                float t;
+                glm::vec3 normal;
+                if ( !sweepAABB( moving[q], deltas[q], cb.box, t, normal ) ) continue;
+
+                SweepHit & hit = out_hits[q];
+                if ( hit.layer == LAYER_NONE || t < hit.t || ( t == hit.t && hitLayer[q] == layer && pair.item < hitItem[q] ) ) {
+                    hitLayer[q] = layer;
+                    hitItem[q] = pair.item;
+                    hit.layer = cb.layer;
+                    hit.entity = cb.entity;
+                    hit.box = cb.box;
+                    hit.t = t;
+                    hit.normal = normal;
+                }
+            }
+        }
+    });
 }
 
 void
-Level::update()
+Level::draw( RenderSnapshot & out,
+             float interpolation )
 {
-    m_scene_root->update();
+    PROFILE_SCOPE( "Level::draw" );
+
+    out.lights.insert( out.lights.end(), m_lights.begin(), m_lights.end() );
+
+    // Scenery is placed in world space
+    JobSystem * jobs = JobSystem::getInstance();
+    m_packets.begin( out.V );
 
-    // bullet collisions
+    jobs->parallelFor( m_static.size(), DRAW_GRAIN, [&]( int begin, int end ) {
+        for ( int i = begin; i < end; i++ ) {
+            const StaticGeometry * geometry = m_static[i];
+            const AABB & box = geometry->getBoundingBox();
+            if ( !m_frustum.intersects( box.min, box.max ) ) continue;
+
+            DrawItem item;
+            geometry->getDrawItem( interpolation, item );
+            m_packets.add( item );
+        }
+    });
+
+    // Enemies, bullets and particles; none are culled
+    drawMeshes( m_world, interpolation, m_packets );
+
+    // Particles sort after everything opaque so alpha transparency works
+    m_packets.merge( out.items );
+}
+
+void
+Level::setViewProjection( const glm::mat4 & viewProjection )
+{
+    m_frustum = Frustum( viewProjection );
+}
+
+void
+Level::update()
+{
+    PROFILE_SCOPE( "Level::update" );
+
+    // Static geometry never changes so don't bother visiting it. Animated
+    // scenery only plays while the camera can see it. Stepping a keyframe
+    // only touches that scenery's own counters, so culling and stepping are
+    // split over threads together.
+    JobSystem::getInstance()->parallelFor( m_animated.size(), CULL_GRAIN, [&]( int begin, int end ) {
+        for ( int i = begin; i < end; i++ ) {
+            StaticGeometry * geometry = m_animated[i];
+            const AABB & box = geometry->getBoundingBox();
+            if ( m_frustum.intersects( box.min, box.max ) ) geometry->update();
+        }
+    });
+
+    // Everything else runs through the world's systems. Enemies decide
+    // where to go, everything moves, then enemies that walked into the
+    // player or cake back off.
+    updateFlowTargets();
+    thinkEnemies( m_world, *this, m_crowd, ++m_aiFrame );
+    emitParticles( m_world );
+    integrateMotion( m_world );
+    animateMeshes( m_world );
+    updateEnemies( m_world, *this );
+    m_enemyCollidersDirty = true;
+    ageLifetimes( m_world );
+
+    // bullet collisions, in three passes so every bullet is resolved every
+    // frame: gather where all bullets went, find what each one hit against
+    // the same snapshot of the level, then apply the results in order.
     {
-        std::list<Bullet *> toRemove;
+        std::vector<Entity> bullets;
+        unsigned bulletMask = LAYER_NONE;
+        std::vector<AABB> bulletStarts;
+        std::vector<glm::vec3> bulletMoves;
+
+        // Bullets move a long way each frame; sweep from where each one was
+        // at the start of the frame so thin walls and enemies can't be
+        // skipped over.
+        for ( int i = 0; i < m_world.colliders.size(); i++ ) {
+            const Collider & c = m_world.colliders[i];
+            if ( !( c.layer & LAYER_BULLET ) ) continue;
+
+            Entity e = m_world.colliders.getEntity( i );
+            Transform * t = m_world.transforms.find( e );
+            Velocity * v = m_world.velocities.find( e );
+            if ( !t || !v ) continue;
+
+            glm::vec3 move = t->position - t->previous;
+            bullets.push_back( e );
+            bulletMask |= c.mask;
+            bulletStarts.push_back( c.box.translated( t->previous ) );
+            bulletMoves.push_back( move );
+        }
 
-        // check collisions
-        for ( SceneNode * bNode : m_scene_bullets->children ) {
-            ParticleSystemConfig psys_conf_bullet_trail = ParticleSystem::getConfiguration( "trail" );
-            psys_conf_bullet_trail.position[PSYS_MEAN] = bNode->getLocation();
-            ParticleSystem * parts = new ParticleSystem( psys_conf_bullet_trail, 1 );
-            m_scene_particle_systems->add_child( parts );
-
-            // we know that only bullets are in the bullet list
-            Bullet * b = (Bullet *)bNode;
-            SceneNode * collision;
-
-            // check collision with static geometry
-            collision = m_scene_static->isCollidingWith( *b );
-            if ( collision ) {
-                toRemove.push_back( b );
-                //SoundCache::getInstance()->playSound( "Assets/Hit_Hurt13.wav" );
+        std::vector<SweepHit> hits;
+        sweepMany( bulletStarts, bulletMoves, bulletMask, hits );
 
-                break;
-            }
+        // Damage enemies in order of impact so the bullet that got there
+        // first gets the kill; bullet order breaks ties.
+        std::vector<int> enemyHits;
+        for ( std::size_t i = 0; i < bullets.size(); i++ ) {
+            if ( hits[i].layer == LAYER_ENEMY && hits[i].entity != NULL_ENTITY ) enemyHits.push_back( i );
+        }
+        std::stable_sort( enemyHits.begin(), enemyHits.end(), [&]( int a, int b ) {
+            return hits[a].t < hits[b].t;
+        });
+        std::vector<Entity> victims;
+        victims.reserve( enemyHits.size() );
+        for ( int i : enemyHits ) {
+            victims.push_back( hits[i].entity );
+        }
+        damageEnemies( m_world, victims );
 
-            // check collision with enemies
-            collision = m_scene_enemies->isCollidingWith( *b );
-            if ( collision ) {
-                Enemy * ene = (Enemy *)collision;
-                toRemove.push_back( b );
-                ene->decrementLife();
-                if ( ene->isDead() ) {
-                    m_scene_enemies->children.remove( collision );
-                    delete collision;
-                    break;
-                }
-            }
+        for ( std::size_t i = 0; i < bullets.size(); i++ ) {
+            // Creating systems adds lifetimes, so look this up first
+            Lifetime * life = m_world.lifetimes.find( bullets[i] );
+            bool expired = life && life->remaining <= 0;
+            Transform * t = m_world.transforms.find( bullets[i] );
 
-            // check if expired
-            if ( b->isDead() ) {
-                toRemove.push_back( b );
-                break;
+            ParticleSystemConfig psys_conf_bullet_trail = ParticleSystem::getConfiguration( "trail" );
+            psys_conf_bullet_trail.position[PSYS_MEAN] = t->position;
+            ParticleSystem::create( m_world, psys_conf_bullet_trail, 1 );
+
+            if ( hits[i].layer != LAYER_NONE ) {
+                // Back up to where it hit so the impact effect lands there
+                t->position += bulletMoves[i] * ( hits[i].t - 1.f );
+                Health * health = m_world.healths.find( bullets[i] );
+                if ( health ) health->points--;
+                //SoundCache::getInstance()->playSound( "Assets/Hit_Hurt13.wav" );
+            } else if ( !expired ) {
+                continue;
             }
-        }
 
-        for ( Bullet * b : toRemove ) {
             // add new particle system at bullet location
             ParticleSystemConfig psys_conf_bullet = ParticleSystem::getConfiguration( "impact" );
-            psys_conf_bullet.position[PSYS_MEAN] = b->getLocation();
-            ParticleSystem * parts = new ParticleSystem( psys_conf_bullet, 1 );
-            m_scene_particle_systems->add_child( parts );
-
-            // delete bullet
-            m_scene_bullets->children.remove( b );
-            delete b;
+            psys_conf_bullet.position[PSYS_MEAN] = t->position;
+            ParticleSystem::create( m_world, psys_conf_bullet, 1 );
         }
     }
 
-    // remove dead particle systems
-    {
-        std::list<ParticleSystem *> toRemove;
-        for ( SceneNode * sysNode : m_scene_particle_systems->children ) {
-            ParticleSystem * psys = (ParticleSystem *)sysNode;
-            if ( psys->isDead() ) {
-                toRemove.push_back( psys );
-            }
-        }
+    // spent bullets, finished particle systems, faded particles and enemies
+    // done dying
+    removeDeadEntities( m_world );
+}
 
-        for ( ParticleSystem * psys : toRemove ) {
-            m_scene_particle_systems->children.remove( psys );
-            delete psys;
-        }
+void
+Level::buildLayer( int index )
+{
+    std::vector<AABB> boxes;
+    boxes.reserve( m_layers[index].boxes.size() );
+    for ( const CollisionBox & cb : m_layers[index].boxes ) {
+        boxes.push_back( cb.box );
     }
+    m_layers[index].bvh.build( boxes );
+}
 
-    // remove dead enemies
-    {
-        std::list<Enemy *> toRemove;
-        for ( SceneNode * sysNode : m_scene_enemies->children ) {
-            Enemy * psys = (Enemy *)sysNode;
-            if ( psys->isDead() ) {
-                toRemove.push_back( psys );
+void
+Level::buildStaticCollision()
+{
+    for ( const StaticGeometry * geometry : m_static ) {
+        unsigned layer = geometry->getCollisionLayer();
+        if ( layer == LAYER_NONE ) continue;
+
+        CollisionBox cb = { geometry->getBoundingBox(), layer, NULL_ENTITY };
+        m_layers[layerIndex( layer )].boxes.push_back( cb );
+    }
+
+    // Level tiles are cubes sitting face to face; collide with a few big boxes
+    // instead so queries are cheaper and there are no seams to catch on.
+    std::vector<CollisionBox> & staticBoxes = m_layers[layerIndex( LAYER_STATIC )].boxes;
+    m_unmergedStaticBoxes = staticBoxes.size();
+    mergeCollisionBoxes( staticBoxes );
+
+    for ( int i = 0; i < COLLISION_LAYER_COUNT; i++ ) {
+        buildLayer( i );
+    }
+}
+
+void
+Level::buildFlowField( float minY,
+                       float maxY )
+{
+    AABB bounds = m_layers[layerIndex( LAYER_STATIC )].bvh.getBounds();
+    if ( bounds.min.x > bounds.max.x ) return;
+
+    // Half a level tile; enough to find the gaps between things
+    const float cellSize = 1.f;
+    int width = (int)std::ceil( ( bounds.max.x - bounds.min.x ) / cellSize );
+    int depth = (int)std::ceil( ( bounds.max.z - bounds.min.z ) / cellSize );
+    m_flowField.resize( glm::vec2( bounds.min.x, bounds.min.z ), width, depth, cellSize );
+
+    // Probe a little inside each cell so neighbours that only touch it
+    // don't count
+    const float inset = 0.05f * cellSize;
+    int blocked = 0;
+    for ( int z = 0; z < depth; z++ ) {
+        for ( int x = 0; x < width; x++ ) {
+            glm::vec2 c = m_flowField.getCellCenter( x, z );
+            float h = 0.5f * cellSize - inset;
+            AABB probe( glm::vec3( c.x - h, minY, c.y - h ), glm::vec3( c.x + h, maxY, c.y + h ) );
+            if ( findInLayer( layerIndex( LAYER_STATIC ), probe ) || findInLayer( layerIndex( LAYER_CAKE ), probe ) ) {
+                m_flowField.setBlocked( x, z, true );
+                blocked++;
             }
         }
+    }
+    m_blockedFlowCells = blocked;
 
-        for ( Enemy * psys : toRemove ) {
-            m_scene_enemies->children.remove( psys );
-            delete psys;
+    m_flowTargets.clear();
+    updateFlowTargets();
+}
+
+void
+Level::updateFlowTargets()
+{
+    if ( m_flowField.empty() ) return;
+
+    m_flowTargets.clear();
+    if ( m_cake ) m_flowTargets.push_back( m_cake->getLocation() );
+    m_flowTargets.push_back( Player::getInstance()->getLocation() );
+
+    // Cheap unless a target moved to a new cell
+    m_flowField.setTargets( m_flowTargets );
+}
+
+glm::vec3
+Level::getFlowDirection( const glm::vec3 & position )
+const {
+    glm::vec3 direction;
+    if ( m_flowField.sample( position, direction ) ) return direction;
+
+    // Off the field or already there; head straight for the closest target
+    glm::vec3 target( 0.f );
+    float best = std::numeric_limits<float>::max();
+    for ( const glm::vec3 & t : m_flowTargets ) {
+        glm::vec3 d = t - position;
+        d.y = 0;
+        if ( glm::dot( d, d ) < best ) {
+            best = glm::dot( d, d );
+            target = t;
         }
     }
+
+    direction = target - position;
+    direction.y = 0;
+    if ( direction == glm::vec3( 0.f ) ) return direction;
+    return glm::normalize( direction );
+}
+
+const std::vector<glm::vec3> &
+Level::getFlowTargets()
+const {
+    return m_flowTargets;
 }
 
 void
-Level::updateLightUniforms( Shader * shader )
+Level::refreshEnemyColliders()
 {
-    GLuint location;
+    if ( !m_enemyCollidersDirty ) return;
+    m_enemyCollidersDirty = false;
 
-    for ( int i = 0; i < m_lights.size(); i++ ) {
-        char uniformString[32];
+    int index = layerIndex( LAYER_ENEMY );
+    m_layers[index].boxes.clear();
+    for ( int i = 0; i < m_world.colliders.size(); i++ ) {
+        const Collider & c = m_world.colliders[i];
+        if ( c.layer != LAYER_ENEMY ) continue;
 
-        snprintf( uniformString, 32, "LightColor[%d]", i );
-        location = shader->getUniformLocation(uniformString);
-        glUniform3f( location, m_lights[i].intensity.r, m_lights[i].intensity.g, m_lights[i].intensity.b );
+        Entity e = m_world.colliders.getEntity( i );
+        const Transform * t = m_world.transforms.find( e );
+        if ( !t ) continue;
 
-        snprintf( uniformString, 32, "LightPosition_WS[%d]", i );
-        location = shader->getUniformLocation(uniformString);
-        glUniform3f( location, m_lights[i].position.x, m_lights[i].position.y, m_lights[i].position.z );
-
-        snprintf( uniformString, 32, "LightPower[%d]", i );
-        location = shader->getUniformLocation(uniformString);
-        glUniform1f( location, m_lights[i].power );
+        CollisionBox cb = { c.box.translated( t->position ), LAYER_ENEMY, e };
+        m_layers[index].boxes.push_back( cb );
     }
-
-    location = shader->getUniformLocation("numLights");
-    glUniform1i( location, m_lights.size() );
+    buildLayer( index );
 }
 
 void
@@ -262,7 +720,7 @@ Level::makeTestLevel()
 
     Model * static_cube = cache_model->getAnimation( "testAnim3" );
 
-    GeometryNode * child( nullptr );
+    StaticGeometry * child( nullptr );
 
     // floor
     for ( int z = -10; z <= 10; z++ ) {
@@ -276,9 +734,8 @@ Level::makeTestLevel()
                 tmp = cache_texture->getMaterial( "floor1" );
             }
 
-            child = new GeometryNode( static_cube, tmp, shader );
+            child = addStaticGeometry( static_cube, tmp );
             child->translate( glm::vec3(x*2.0, -5.0, z*2.0) );
-            addStaticGeometry( child );
         }
     }
 
@@ -294,9 +751,8 @@ Level::makeTestLevel()
                 tmp = cache_texture->getMaterial( "ceiling1" );
             }
 
-            child = new GeometryNode( static_cube, tmp, shader );
+            child = addStaticGeometry( static_cube, tmp );
             child->translate( glm::vec3(x*2.0, 5.0, z*2.0) );
-            addStaticGeometry( child );
         }
     }
 
@@ -313,9 +769,8 @@ Level::makeTestLevel()
                     tmp = cache_texture->getMaterial( "wall1" );
                 }
 
-                child = new GeometryNode( static_cube, tmp, shader );
+                child = addStaticGeometry( static_cube, tmp );
                 child->translate( glm::vec3(x*2.0, -3.0+y*2, z*2.0) );
-                addStaticGeometry( child );
             }
         }
     }
@@ -323,16 +778,14 @@ Level::makeTestLevel()
     // CAKE
     Model * mdl_table = cache_model->getAnimation( "table" );
     Material * mat_table = cache_texture->getMaterial( "table" );
-    child = new GeometryNode( mdl_table, mat_table, shader );
+    child = addStaticGeometry( mdl_table, mat_table );
     child->translate( glm::vec3( 0.f, -4.f, 0.f ) );
-    addStaticGeometry( child );
 
     Model * mdl_cake = cache_model->getAnimation( "cake" );
     Material * mat_cake = cache_texture->getMaterial( "cake" );
-    m_cake = new GeometryNode( mdl_cake, mat_cake, shader );
+    m_cake = addStaticGeometry( mdl_cake, mat_cake, LAYER_CAKE );
     m_cake->scale( glm::vec3( 0.5f, 0.5f, 0.5f ) );
     m_cake->translate( glm::vec3( 0.f, -2.8f, 0.f ) );
-    addStaticGeometry( m_cake );
 
     Light white_follow_player = { glm::vec3(0, 2.f, 0), glm::vec3(0.5f, 0.5f, 0.5f), 40.f };
     Light red_light = { glm::vec3(16.f, 0.f, 0.f), glm::vec3(1.0f, 0.1f, 0.1f), 40.f };
@@ -344,6 +797,11 @@ Level::makeTestLevel()
     addLight( green_light );
     addLight( blue_light );
     addLight( yellow_light );
+
+    buildStaticCollision();
+
+    // Enemies walk on the floor (top at y = -4) and are about two units tall
+    buildFlowField( -3.9f, -2.1f );
 }
 
 void
@@ -355,14 +813,13 @@ Level::makeMenuScene()
     Material * mat_floor = cache_texture->getMaterial( "floor1" );
     Model * static_cube = cache_model->getAnimation( "testAnim3" );
 
-    GeometryNode * child;
+    StaticGeometry * child;
 
     // floor
     for ( int z = -8; z <= 8; z++ ) {
         for ( int x = -8; x <= 8; x++ ) {
-            child = new GeometryNode( static_cube, mat_floor, shader );
+            child = addStaticGeometry( static_cube, mat_floor );
             child->translate( glm::vec3(x*2.0, 0.0, z*2.0) );
-            addStaticGeometry( child );
         }
     }
 
@@ -370,8 +827,7 @@ Level::makeMenuScene()
     Material * mat_testanim2 = cache_texture->getMaterial( "spike0" );
 
     for ( float i = 0.f; i < 360.f; i+= 60.f ) {
-        child = new GeometryNode( mdl_testAnim2, mat_testanim2, shader );
-        addStaticGeometry( child );
+        child = addStaticGeometry( mdl_testAnim2, mat_testanim2 );
 
         glm::mat4 R = glm::rotate( glm::radians(i), glm::vec3(0.f, 1.f, 0.f) );
         glm::vec4 spawnLocation = R * glm::vec4(1.f, 1.25f, 0.f, 1.f);
@@ -382,20 +838,20 @@ Level::makeMenuScene()
 
     Model * mdl_table = cache_model->getAnimation( "table" );
     Material * mat_table = cache_texture->getMaterial( "table" );
-    child = new GeometryNode( mdl_table, mat_table, shader );
+    child = addStaticGeometry( mdl_table, mat_table );
     child->scale( glm::vec3( 0.25f, 0.25f, 0.25f ) );
     child->translate( glm::vec3( 0.f, 1.25f, 0.f ) );
-    addStaticGeometry( child );
 
     Model * mdl_cake = cache_model->getAnimation( "cake" );
     Material * mat_cake = cache_texture->getMaterial( "cake" );
-    child = new GeometryNode( mdl_cake, mat_cake, shader );
+    child = addStaticGeometry( mdl_cake, mat_cake );
     child->scale( glm::vec3( 0.1f, 0.1f, 0.1f ) );
     child->translate( glm::vec3( 0.f, 1.6f, 0.f ) );
-    addStaticGeometry( child );
 
     Light white_follow_player = { glm::vec3(0, 4.f, 0), glm::vec3(1.0f, 0.75f, 0.5f), 10.f };
     addLight( white_follow_player );
+
+    buildStaticCollision();
 }
 
 void
@@ -3,18 +3,57 @@
 #include <vector>
 #include <glm/glm.hpp>
 #include <string>
+#include <cstdint>
 
-class SceneNode;
-class Shader;
-class GeometryNode;
-class Enemy;
-class Bullet;
-class ParticleSystem;
-
-struct Light {
-    glm::vec3 position;
-    glm::vec3 intensity;
-    float power;
+#include "Arena.hpp"
+#include "BVH.hpp"
+#include "CollisionMerge.hpp"
+#include "DrawPackets.hpp"
+#include "FlowField.hpp"
+#include "Light.hpp"
+#include "RenderStats.hpp"
+#include "SpatialHash.hpp"
+#include "Frustum.hpp"
+#include "SceneNode.hpp"
+#include "World.hpp"
+
+struct RenderSnapshot;
+class StaticGeometry;
+class Model;
+class Material;
+
+/**
+ * @brief The first thing a moving box runs into.
+ */
+struct SweepHit {
+    /** @brief The CollisionLayer of what was hit; LAYER_NONE if nothing. */
+    unsigned layer;
+    /** @brief The enemy that was hit; NULL_ENTITY for scenery or nothing. */
+    Entity entity;
+    /** @brief The collision box that was hit. */
+    AABB box;
+    /** @brief Time of impact as a fraction of the motion, in [0, 1]. */
+    float t;
+    /** @brief Face normal at the impact; zero if it started inside. */
+    glm::vec3 normal;
+};
+
+/**
+ * @brief The first thing a ray runs into.
+ */
+struct RayHit {
+    /** @brief The CollisionLayer of what was hit; LAYER_NONE if nothing. */
+    unsigned layer;
+    /** @brief The enemy that was hit; NULL_ENTITY for scenery or nothing. */
+    Entity entity;
+    /** @brief The collision box that was hit. */
+    AABB box;
+    /** @brief World distance from the ray origin to the hit. */
+    float distance;
+    /** @brief Face normal at the hit; zero if the ray started inside. */
+    glm::vec3 normal;
+    /** @brief Where the ray hit, in world space. */
+    glm::vec3 point;
 };
 
 /**
@@ -28,33 +67,153 @@ public:
     /** @brief Free all objects added to the level. */
     ~Level();
 
-    void addStaticGeometry( GeometryNode * node );
+    /**
+     * @brief Remove everything from the level so it can be built again.
+     * @remark Static geometry is released all at once with the arena; none
+     *         of it has a destructor to run.
+     */
+    void clear();
+
+    /**
+     * @brief Create a piece of static geometry owned by the level.
+     * @param prim The model to use.
+     * @param mat The material to draw the model.
+     * @param layer The collision layer to put it on.
+     * @return The new scenery; owned by the level arena, never delete it!
+     */
+    StaticGeometry * addStaticGeometry( Model * prim, Material * mat, unsigned layer = LAYER_STATIC );
 
-    void addEnemy( Enemy * enemy );
+    /**
+     * @brief Create a new enemy in the level's world.
+     * @param prim The model its collision box comes from.
+     * @param mat The enemy material.
+     * @param position Where it spawns.
+     * @return The enemy entity; see Enemy::create.
+     */
+    Entity addEnemy( Model * prim, Material * mat, const glm::vec3 & position );
 
-    void addBullet( Bullet * bullet );
+    /**
+     * @brief Get the entities in the level.
+     * @remark Enemies, bullets and particle systems live here; see
+     *         Enemy::create, Bullet::create and ParticleSystem::create.
+     */
+    World & getWorld();
 
-    void addParticleSystem( ParticleSystem * psys );
+    /** @brief Count what the level holds, filling the level's part of out. */
+    void getSceneStats( SceneStats & out ) const;
+
+    /**
+     * @brief Fold where every entity is into a checksum.
+     * @see checksumBytes
+     */
+    std::uint64_t getChecksum( std::uint64_t hash ) const;
 
     void addLight( const Light & light );
 
-    GeometryNode * findStaticCollision( SceneNode & other );
+    /** @brief Get whether a world space box overlaps the cake. */
+    bool findCakeCollision( const AABB & box );
 
-    Enemy * findEnemyCollision( SceneNode & other );
+    /**
+     * @brief Find the first solid thing along a ray.
+     * @param origin Where the ray starts.
+     * @param direction Which way it goes; doesn't need to be unit length.
+     * @param maxDistance Ignore anything further away than this.
+     * @param mask The collision layers to look at.
+     * @param out_hit Where to store the closest hit.
+     * @return true if anything was hit.
+     */
+    bool raycast( const glm::vec3 & origin, const glm::vec3 & direction, float maxDistance, unsigned mask, RayHit & out_hit );
 
-    SceneNode * findCakeCollision( SceneNode & other );
+    /**
+     * @brief Cast many rays at once.
+     * @param origins Where each ray starts.
+     * @param directions Which way each ray goes.
+     * @param maxDistance Ignore anything further away than this.
+     * @param mask The collision layers to look at.
+     * @param out_hits Replaced with one result per ray; layer is LAYER_NONE
+     *                 for rays that hit nothing.
+     * @details Same results as raycast() for each ray. The rays are split
+     *          over threads and each share goes down every layer tree as one
+     *          packet, so rays fired from about the same place (a spread of
+     *          shots, sight checks from one enemy) share most of the work.
+     */
+    void raycastMany( const std::vector<glm::vec3> & origins, const std::vector<glm::vec3> & directions, float maxDistance, unsigned mask, std::vector<RayHit> & out_hits );
+
+    /**
+     * @brief Get whether nothing solid is between two points.
+     * @param mask The collision layers that block sight.
+     */
+    bool hasLineOfSight( const glm::vec3 & from, const glm::vec3 & to, unsigned mask = LAYER_STATIC );
 
-    SceneNode * findCollisionWith( SceneNode & other );
+    /**
+     * @brief Collect every solid collision box overlapping a region.
+     * @param region The box to search.
+     * @param mask The collision layers to look at.
+     * @param out Where to append the boxes found.
+     * @remark For callers that test many motions in one small area, like the
+     *         player sliding along walls: one broadphase visit, then test the
+     *         handful of boxes directly.
+     */
+    void findCandidates( const AABB & region, unsigned mask, std::vector<CollisionBox> & out );
+
+    /**
+     * @brief Find the first solid thing a box runs into while moving.
+     * @param moving The box at the start of the motion.
+     * @param delta The whole motion.
+     * @param mask The collision layers to look at.
+     * @param out_hit Where to store the earliest hit.
+     * @return true if anything was hit.
+     * @remark Continuous, so fast movers can't pass through thin things
+     *         between frames.
+     */
+    bool sweep( const AABB & moving, const glm::vec3 & delta, unsigned mask, SweepHit & out_hit );
+
+    /**
+     * @brief Sweep many boxes at once.
+     * @param moving The boxes at the start of their motion.
+     * @param deltas The motion of each box.
+     * @param mask The collision layers to look at.
+     * @param out_hits Replaced with one result per box; layer is LAYER_NONE
+     *                 for boxes that hit nothing.
+     */
+    void sweepMany( const std::vector<AABB> & moving, const std::vector<glm::vec3> & deltas, unsigned mask, std::vector<SweepHit> & out_hits );
 
     /**
-     * @brief Draw the level
-     * @param shader The shader used to draw
+     * @brief Add everything in the level to a frame
+     * @param out The frame to add the lights and models to; its V must be set.
+     * @param interpolation How far between the last two updates to draw
+     *                      moving things, in [0, 1].
+     * @details Draw items are made in parallel and sorted into draw order.
+     *          Static geometry outside the view frustum is left out.
      */
-    void draw( Shader * shader );
+    void draw( RenderSnapshot & out, float interpolation );
 
-    /** @brief Update all level objects */
+    /**
+     * @brief Update all level objects
+     * @remark Only animated scenery and entities are visited; static
+     *         geometry costs nothing here.
+     */
     void update();
 
+    /**
+     * @brief Tell the level where the camera is looking.
+     * @param viewProjection The camera projection matrix times view matrix.
+     * @remark Animated scenery outside the view stops playing.
+     */
+    void setViewProjection( const glm::mat4 & viewProjection );
+
+    /**
+     * @brief Get which way an enemy should walk to reach the cake or player.
+     * @param position Where the enemy is.
+     * @return Unit direction in the XZ plane.
+     * @remark Follows the flow field around obstacles; straight at the nearest
+     *         target when off the field.
+     */
+    glm::vec3 getFlowDirection( const glm::vec3 & position ) const;
+
+    /** @brief Get where the flow field leads; the cake and the player. */
+    const std::vector<glm::vec3> & getFlowTargets() const;
+
     void makeTestLevel();
 
     void makeMenuScene();
@@ -62,25 +221,104 @@ public:
     void lightFollowPlayer();
 
 private:
+    /** @brief Backing memory for static geometry; lives as long as the level. */
+    Arena m_arena;
     /** @brief Collection of lights; size() < 16 */
     std::vector<Light> m_lights;
-    /** @brief Scene root node. */
-    SceneNode * m_scene_root;
-    /** @brief Node for all static geometry. */
-    SceneNode * m_scene_static;
-    /** @brief Node for all particle systems. */
-    SceneNode * m_scene_particle_systems;
-    /** @brief Node for all enemies. */
-    SceneNode * m_scene_enemies;
-    /** @brief Node for all bullets. */
-    SceneNode * m_scene_bullets;
-    GeometryNode * m_cake;
-
-    /**
-     * @brief Give the light uniforms to the shader
-     * @param shader The shader that needs the light info.
-     */
-    void updateLightUniforms( Shader * shader );
+    StaticGeometry * m_cake;
+    /**
+     * @brief All level scenery; lives in m_arena, outside the scene graph.
+     * @remark Only pointers, so this is released with a single free too.
+     */
+    std::vector<StaticGeometry *> m_static;
+    /** @brief Scenery that plays an animation; subset of m_static. */
+    std::vector<StaticGeometry *> m_animated;
+    /** @brief What the camera can see, used to pause scenery animations. */
+    Frustum m_frustum;
+    /** @brief Enemies, bullets, particle systems and particles. */
+    World m_world;
+    /** @brief Draw items for the frame being made; reused every frame. */
+    DrawPackets m_packets;
+    /**
+     * @brief Broadphase for the solid things on one collision layer.
+     */
+    struct LayerBucket {
+        /** @brief Collision boxes; BVH item i is boxes[i]. */
+        std::vector<CollisionBox> boxes;
+        /** @brief Hierarchy over boxes. */
+        BVH bvh;
+    };
+
+    /**
+     * @brief One bucket per collision layer; bucket i holds layer 1 << i.
+     * @remark Static geometry and the cake are built once with the level.
+     *         Static boxes are merged so there are far fewer of them. Enemies
+     *         are rebuilt when they move.
+     */
+    LayerBucket m_layers[COLLISION_LAYER_COUNT];
+    /** @brief Static boxes before merging, for the stats window. */
+    int m_unmergedStaticBoxes;
+    /** @brief Set when enemies moved or were added since the last refresh. */
+    bool m_enemyCollidersDirty;
+    /** @brief Walking directions to the cake and player for enemies. */
+    FlowField m_flowField;
+    /** @brief Where m_flowField is leading; the cake and the player. */
+    std::vector<glm::vec3> m_flowTargets;
+    /** @brief Flow field cells nothing can walk through. */
+    int m_blockedFlowCells;
+    /** @brief Enemy positions, rebuilt every update for crowd steering. */
+    SpatialHash m_crowd;
+    /** @brief Counts updates to pick which AI bucket thinks. */
+    int m_aiFrame;
+
+    /** @brief Rebuild the hierarchy of a bucket from its boxes. */
+    void buildLayer( int index );
+
+    /** @brief Closest solid thing a unit length ray hits in one bucket. */
+    bool castInLayer( int index, const Ray & ray, float maxDistance, RayHit & out_hit );
+
+    /**
+     * @brief Turn the closest box a ray hit in a bucket into a RayHit.
+     * @remark Looks past the box if it stopped being solid.
+     */
+    bool resolveLayerHit( int index, const Ray & ray, float maxDistance, BVHHit hit, RayHit & out_hit ) const;
+
+    /** @brief Find a solid box overlapping a box in one bucket. */
+    const CollisionBox * findInLayer( int index, const AABB & query );
+
+    /**
+     * @brief Get whether a box in a bucket still blocks things.
+     * @remark Enemies stop being solid when they lose their collider on
+     *         dying, which can be between bucket rebuilds. Scenery always is.
+     */
+    bool isSolid( const CollisionBox & cb ) const;
+
+    /**
+     * @brief Build the collision buckets for static geometry.
+     * @remark Call once all static geometry has been added. Nodes used for
+     *         rendering are left alone.
+     */
+    void buildStaticCollision();
+
+    /**
+     * @brief Lay the flow field over the static geometry.
+     * @param minY Bottom of the space enemies walk through.
+     * @param maxY Top of the space enemies walk through.
+     * @remark A cell is blocked if anything static or the cake is in that
+     *         space. Call after buildStaticCollision().
+     */
+    void buildFlowField( float minY, float maxY );
+
+    /** @brief Point the flow field at wherever the cake and player are now. */
+    void updateFlowTargets();
+
+    /**
+     * @brief Rebuild the enemy bucket from the world's colliders if the
+     *        enemies changed.
+     * @remark Enemies move every frame so this is done at most once per frame,
+     *         on the first query that needs it.
+     */
+    void refreshEnemyColliders();
 
 
 };
\ No newline at end of file
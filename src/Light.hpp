@@ -0,0 +1,15 @@
+/**
+ * @file Light.hpp
+ * @brief A point light in the level.
+ * @author Michael Hitchens
+ */
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+struct Light {
+    glm::vec3 position;
+    glm::vec3 intensity;
+    float power;
+};
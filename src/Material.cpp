@@ -5,6 +5,7 @@
 #include "GlErrorCheck.hpp"
 #include "Exception.hpp"
 #include "Shader.hpp"
+#include "RenderStats.hpp"
 
 void
 Material::setProperties( Texture * diffuse,
@@ -23,7 +24,8 @@ Material::setProperties( Texture * diffuse,
 }
 
 void
-Material::bind( Shader * shader )
+Material::bind( Shader * shader,
+                RenderStats & stats )
 {
     if ( m_map_diffuse == nullptr ) {
         throw Exception( "Material has no properties, can't bind" );
@@ -37,6 +39,7 @@ Material::bind( Shader * shader )
     glUniform3f(location, m_specColor.x, m_specColor.y, m_specColor.z);
     location = shader->getUniformLocation("p");
     glUniform1f(location, m_specCoef);
+    stats.uniformUploads += 2;
 
     // bind diffuse
     glActiveTexture( GL_TEXTURE0 + LAYOUT_DIFFUSE );
@@ -50,11 +53,13 @@ Material::bind( Shader * shader )
     // bind self illum map
     glActiveTexture( GL_TEXTURE0 + LAYOUT_SELFILLUM );
     m_map_selfillum->bind();
+    stats.textureBinds += 4;
     CHECK_GL_ERRORS;
 }
 
 void
-Material::updateTextureUniforms( Shader * shader )
+Material::updateTextureUniforms( Shader * shader,
+                                 RenderStats & stats )
 {
     GLuint location;
 
@@ -66,4 +71,5 @@ Material::updateTextureUniforms( Shader * shader )
     glUniform1i(location, LAYOUT_NORMAL);
     location = shader->getUniformLocation("selfillumMap");
     glUniform1i(location, LAYOUT_SELFILLUM);
+    stats.uniformUploads += 4;
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 
 class Texture;
 class Shader;
+struct RenderStats;
 
 /** @brief A collection of surface properties. */
 class Material {
@@ -17,9 +18,9 @@ public:
 
     /** @pre Shader must be enabled.
     */
-    void bind( Shader * shader );
+    void bind( Shader * shader, RenderStats & stats );
 
-    static void updateTextureUniforms( Shader * shader );
+    static void updateTextureUniforms( Shader * shader, RenderStats & stats );
 
 private:
     /** @brief Diffuse texture to apply to geomtry based on UVs */
@@ -7,7 +7,7 @@
 #include <cstdio>
 
 Model::Model():
-    m_vao(0),
+    m_vaos(),
     m_keys(),
     m_keyLength()
 {
@@ -86,4 +86,41 @@ bool
 Model::isAnimated()
 const {
     return getKeyframeCount() > 1;
-}
\ No newline at end of file
+}
+
+GLuint
+Model::getVertexArray( int i )
+{
+    if ( m_keys.empty() ) {
+        throw Exception( "Model has no keyframes to draw!" );
+    }
+
+    if ( m_vaos.size() != m_keys.size() ) {
+        m_vaos.resize( m_keys.size(), 0 );
+    }
+
+    int curFrame = i % m_keys.size();
+    GLuint & vao = m_vaos[curFrame];
+    if ( vao == 0 ) {
+        glGenVertexArrays(1, &vao);
+        glBindVertexArray(vao);
+        bindKeyframe( curFrame );
+
+        // Enabled arrays are part of the VAO so this only needs doing once
+        glEnableVertexAttribArray(Keyframe::LAYOUT_VERTICES_CURRENT);
+        glEnableVertexAttribArray(Keyframe::LAYOUT_UV);
+        glEnableVertexAttribArray(Keyframe::LAYOUT_NORMALS_CURRENT);
+        glEnableVertexAttribArray(Keyframe::LAYOUT_TANGENTS_CURRENT);
+        glEnableVertexAttribArray(Keyframe::LAYOUT_BITANGENTS_CURRENT);
+        glEnableVertexAttribArray(Keyframe::LAYOUT_VERTICES_NEXT);
+        glEnableVertexAttribArray(Keyframe::LAYOUT_NORMALS_NEXT);
+        glEnableVertexAttribArray(Keyframe::LAYOUT_TANGENTS_NEXT);
+        glEnableVertexAttribArray(Keyframe::LAYOUT_BITANGENTS_NEXT);
+
+        // Unbind and check for errors (both good practices)
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+        CHECK_GL_ERRORS;
+    }
+    return vao;
+}
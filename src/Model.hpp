@@ -17,8 +17,8 @@ class Keyframe;
 /**
  * @brief A collection of Keyframe objects.
  * @remark To use you must first make a Model object, then attach 1 or more
- *         Keyframe objects to it using addKeyframe. Before you draw the model
- *         you must call bindKeyFrame.
+ *         Keyframe objects to it using addKeyframe. Draw a keyframe with
+ *         the VAO from getVertexArray.
  * @remark Keyframes are referenced by an internal index that starts at 0 and
  *         increments by 1 for each additional keyframe.
  */
@@ -85,9 +85,18 @@ public:
      */
     bool isAnimated() const;
 
+    /**
+     * @brief Get a VAO with the given keyframe and the one after it bound.
+     * @param i The keyframe index.
+     * @return A VAO shared by everything that draws this model.
+     * @remark Keyframe index is computed modulo the number of keyframes.
+     * @remark Made on first use, so only call this while drawing.
+     */
+    GLuint getVertexArray( int i );
+
 private:
-    /** @brief The vertex array object to bind keyframes to. */
-    GLuint m_vao;
+    /** @brief Shared VAO per keyframe; 0 until first asked for. */
+    std::vector<GLuint> m_vaos;
     /** @brief The keyframe to draw for the model. */
     std::vector<Keyframe *> m_keys;
     /** @brief Index i is the length of the keyframe m_keys[i]. */
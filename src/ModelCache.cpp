@@ -4,6 +4,7 @@
 
 #include "Keyframe.hpp"
 #include "Model.hpp"
+#include "Profiler.hpp"
 
 ModelCache * ModelCache::instance = nullptr;
 
@@ -26,6 +27,7 @@ ModelCache::get( const std::string & filename )
     // lazy load if it doesn't exist
     auto it = m_cache.find( filename );
     if ( it == m_cache.end() ) {
+        PROFILE_SCOPE( "Load model" );
         std::cout << "Loading model " << filename << std::endl;
         m_cache[filename] = new Keyframe( filename.c_str() );
     }
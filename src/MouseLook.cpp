@@ -0,0 +1,31 @@
+#include "MouseLook.hpp"
+
+const float MouseLook::SENSITIVITY = 0.01f;
+
+MouseLook::MouseLook():
+    m_mutex(),
+    m_total( 0, 0 )
+{
+    // nothing else to do
+}
+
+void
+MouseLook::addMotion( int xrel,
+                      int yrel )
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    m_total += glm::ivec2( xrel, yrel );
+}
+
+glm::ivec2
+MouseLook::getTotal()
+const {
+    std::lock_guard<std::mutex> lock( m_mutex );
+    return m_total;
+}
+
+glm::vec3
+MouseLook::toRotation( const glm::ivec2 & motion )
+{
+    return glm::vec3( motion.y * SENSITIVITY, motion.x * SENSITIVITY, 0.f );
+}
@@ -0,0 +1,45 @@
+/**
+ * @file MouseLook.hpp
+ * @brief Interface for MouseLook
+ * @author Michael Hitchens
+ */
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <mutex>
+
+/**
+ * @brief Adds up relative mouse movement for turning the camera.
+ * @details The total only ever grows. Anything that turns the camera keeps
+ *          the total it has already used and turns by the difference, so the
+ *          simulation and the renderer can both read it without taking
+ *          movement from each other.
+ * @remark Movement is added by the thread handling events; the total can be
+ *         read from any thread.
+ */
+class MouseLook {
+public:
+    /** @brief Radians turned per pixel of mouse movement. */
+    static const float SENSITIVITY;
+
+    MouseLook();
+
+    /** @brief Add the movement from one SDL_MOUSEMOTION event. */
+    void addMotion( int xrel, int yrel );
+
+    /** @brief Get all movement added so far, in pixels. */
+    glm::ivec2 getTotal() const;
+
+    /**
+     * @brief Convert mouse movement to a change in Player rotation.
+     * @param motion Movement in pixels.
+     * @return Pitch in x, yaw in y.
+     */
+    static glm::vec3 toRotation( const glm::ivec2 & motion );
+
+private:
+    mutable std::mutex m_mutex;
+    glm::ivec2 m_total;
+};
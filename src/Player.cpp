@@ -1,6 +1,8 @@
 #include "Player.hpp"
 
+#include <algorithm>
 #include <cstdio>
+#include <vector>
 #include "Level.hpp"
 #include "Enemy.hpp"
 #include "globals.hpp"
@@ -14,6 +16,8 @@ const int Player::SHOOT_COOLDOWN = 5;
 const double Player::TERMINAL_VELOCITY = -0.5;
 const double Player::GRAVITY_ACCELERATION = 0.01;
 const double Player::JUMP_INITIAL_VELOCITY = 0.25;
+const int Player::MAX_SLIDE_ITERATIONS = 3;
+const float Player::SKIN = 0.001f;
 
 Player *
 Player::getInstance()
@@ -32,38 +36,76 @@ Player::Player():
     SceneNode("player"),
     m_location(0.0, 0.0, 0.0),
     m_rotation(0.0, 0.0, 0.0),
-    m_up(0.0, 1.0, 0.0),
+    m_prevLocation(0.0, 0.0, 0.0),
     m_speed(0.0), // UNUSED
     m_gravity(0),
     m_canJump(false),
+    m_onGround(false),
+    m_ground(),
     m_shootCooldownTimer(0),
     m_health(100.0)
 {
     m_bbMin = glm::vec3(-0.5, -1, -0.5);
     m_bbMax = glm::vec3(0.5, 1, 0.5);
     setSolid(true);
+    setCollisionLayer( LAYER_PLAYER, LAYER_STATIC | LAYER_ENEMY | LAYER_CAKE );
 }
 
 glm::mat4
 Player::getViewMatrix()
 {
-    glm::vec3 center(m_location);
+    return getViewMatrix( 1.f );
+}
+
+glm::mat4
+Player::getViewMatrix( float interpolation )
+{
+    return makeViewMatrix( getLocation( interpolation ), m_rotation );
+}
+
+glm::vec3
+Player::getLocation( float interpolation )
+const {
+    return glm::mix( m_prevLocation, m_location, interpolation );
+}
+
+glm::vec3
+Player::getRotation()
+const {
+    return m_rotation;
+}
+
+void
+Player::savePreviousState()
+{
+    m_prevLocation = m_location;
+}
+
+glm::mat4
+Player::makeViewMatrix( const glm::vec3 & location,
+                        const glm::vec3 & rotation )
+{
+    glm::vec3 center(location);
     glm::mat4 R(1.0);
-    R = glm::rotate( R, m_rotation.y, glm::vec3(0.0, -1.0, 0.0) );
-    R = glm::rotate( R, m_rotation.x, glm::vec3(-1.0, 0.0, 0.0) );
+    R = glm::rotate( R, rotation.y, glm::vec3(0.0, -1.0, 0.0) );
+    R = glm::rotate( R, rotation.x, glm::vec3(-1.0, 0.0, 0.0) );
     center += glm::vec3( R * glm::vec4(0, 0, -1, 0) );
 
-    return glm::lookAt(m_location, center, m_up );
+    return glm::lookAt( location, center, glm::vec3(0.0, 1.0, 0.0) );
+}
+
+glm::vec3
+Player::clampRotation( glm::vec3 rotation )
+{
+    if ( rotation.x > DEG_TO_RAD(89.0) ) rotation.x = DEG_TO_RAD(89.0);
+    if ( rotation.x < DEG_TO_RAD(-89.0) ) rotation.x = DEG_TO_RAD(-89.0);
+    return rotation;
 }
 
 void
 Player::rotate( glm::vec3 delta )
 {
-    m_rotation += delta;
-
-    // Make sure that pitch stays in bound to prevent errors in glm::lookAt
-    if ( m_rotation.x > DEG_TO_RAD(89.0) ) m_rotation.x = DEG_TO_RAD(89.0);
-    if ( m_rotation.x < DEG_TO_RAD(-89.0) ) m_rotation.x = DEG_TO_RAD(-89.0);
+    m_rotation = clampRotation( m_rotation + delta );
 }
 
 glm::vec3
@@ -79,86 +121,137 @@ Player::setLocation( const glm::vec3 & loc )
     m_bbMin = glm::vec3(-0.5, -1, -0.5) + loc;
     m_bbMax = glm::vec3(0.5, 1, 0.5) + loc;
     m_location = loc;
+    m_prevLocation = loc;
+    m_onGround = false;
 }
 
 bool
-Player::tryToMove( glm::vec3 delta,
-                   Level * level )
+Player::move( const glm::vec3 & walk,
+              Level * level,
+              bool useGravity )
 {
-    //printf( "delta: [%f %f %f]\n", delta.x, delta.y, delta.z );
-
-    /* Check for collisions. This is done by modifying our bounding box then
-     * running collision detection code (which uses the bounding box). We save
-     * the old bounding box so we can restore if collision fails. */
-    glm::vec3 oldBBMax( m_bbMax );
-    glm::vec3 oldBBMin( m_bbMin );
-
     // Note that our current Y axis rotation (from mouse look) affects movement
     glm::mat4 R(1.0);
     R = glm::rotate( R, m_rotation.y, glm::vec3(0.0, -1.0, 0.0) );
-    glm::vec3 modifiedDelta = glm::vec3(R * (glm::vec4( delta.x, delta.y, delta.z, 0 )));
-    m_bbMin += modifiedDelta;
-    m_bbMax += modifiedDelta;
-
-    SceneNode * collision;
-
-    /* On collision we try sliding along the surface. This is only for XZ-plane;
-     * if we detected that our intention was on the Y axis then don't try to
-     * slide. We use delta instead of modifiedDelta because it's closer to the
-     * original intention of the function call. */
-    if ( collision = level->findCollisionWith( *this ) ) {
-
-        // If we collide with an enemy first make sure we apply damage.
-        // The enemy contacting the player and the player contacting the enemy are separate cases.
-        Enemy * enemy = dynamic_cast<Enemy*>(collision);
-        if ( enemy ) {
-            // XXX XXX XXX RTTI is bad blah blah blah XXX XXX XXX
-            hurt( enemy->getDamage() );
-            if ( warning_timer <= 0 ) {
-                warning_timer = warning_cooldown;
-                SoundCache::getInstance()->playSound( "Assets/Laser_Shoot3.wav" );
+    glm::vec3 delta = glm::vec3( R * glm::vec4( walk.x, 0, walk.z, 0 ) );
+
+    // While standing on known ground there's nothing to fall through, so we
+    // only move down once we've walked off it or jumped.
+    if ( m_gravity > 0 ) m_onGround = false;
+    if ( useGravity && !m_onGround ) delta.y = m_gravity;
+
+    AABB box( m_bbMin, m_bbMax );
+
+    // Sliding only ever removes parts of the motion along an axis, so the
+    // whole path stays inside the box swept by the full motion; one search
+    // covers every iteration. It reaches a little further down so the ground
+    // check below can find whatever we walk onto.
+    std::vector<CollisionBox> candidates;
+    if ( delta != glm::vec3( 0.f ) ) {
+        AABB region = box.swept( delta ).expanded( glm::vec3( SKIN ) );
+        region.min.y -= 2.f * SKIN;
+        level->findCandidates( region, getCollisionMask(), candidates );
+    }
+
+    bool landed = false;
+    bool touchedEnemy = false;
+    glm::vec3 remaining = delta;
+
+    for ( int i = 0; i < MAX_SLIDE_ITERATIONS && remaining != glm::vec3( 0.f ); i++ ) {
+        const CollisionBox * hitBox = nullptr;
+        float hitT = 1.f;
+        glm::vec3 hitNormal( 0.f );
+
+        for ( const CollisionBox & cb : candidates ) {
+            float t;
+            glm::vec3 normal;
+            if ( !sweepAABB( box, remaining, cb.box, t, normal ) ) continue;
+
+            // Already inside it (something walked into us); don't get stuck
+            if ( normal == glm::vec3( 0.f ) ) {
+                if ( cb.layer == LAYER_ENEMY ) touchedEnemy = true;
+                continue;
+            }
+
+            if ( !hitBox || t < hitT ) {
+                hitBox = &cb;
+                hitT = t;
+                hitNormal = normal;
             }
         }
 
-        // Again, cut out if we're applying gravity
-        if ( delta.y != 0.0f ) {
-            // Restore old BB so we don't fall through the floor after many timesteps
-            m_bbMin = oldBBMin;
-            m_bbMax = oldBBMax;
-            //printf( "found collision but not sliding because gravity\n" );
-            return false;
+        if ( !hitBox ) {
+            box = box.translated( remaining );
+            break;
         }
 
-        // First try along Z
-        glm::vec3 mdNoX( 0, modifiedDelta.y, modifiedDelta.z );
-        m_bbMin = oldBBMin + mdNoX;
-        m_bbMax = oldBBMax + mdNoX;
-
-        if ( collision = level->findCollisionWith( *this ) ) {
-            // Then try along X
-            glm::vec3 mdNoZ( modifiedDelta.x, modifiedDelta.y, 0 );
-            m_bbMin = oldBBMin + mdNoZ;
-            m_bbMax = oldBBMax + mdNoZ;
-
-            // since we tried X, tried Z, nothing left to do! stuck on corner
-            if ( collision = level->findCollisionWith( *this ) ) {
-                // Restore old BB so we don't clip through geometry
-                m_bbMin = oldBBMin;
-                m_bbMax = oldBBMax;
-                //printf( "no movement whatsoever!" );
-                return false;
-            } else { // X is good so use it!
-                m_location += mdNoZ;
-                return true;
+        // Stop just short of the surface, then slide: drop the part of what's
+        // left that goes into it.
+        float t = std::max( 0.f, hitT - SKIN / glm::length( remaining ) );
+        box = box.translated( remaining * t );
+        remaining *= 1.f - t;
+        remaining -= hitNormal * glm::dot( remaining, hitNormal );
+
+        bool isEnemy = hitBox->layer == LAYER_ENEMY;
+        if ( isEnemy ) touchedEnemy = true;
+
+        if ( hitNormal.y > 0.f ) {
+            landed = true;
+            m_onGround = !isEnemy;
+            m_ground = hitBox->box;
+        } else if ( hitNormal.y < 0.f && m_gravity > 0 ) {
+            // bumped our head
+            m_gravity = 0;
+        }
+    }
+
+    m_location += box.min - m_bbMin;
+    m_bbMin = box.min;
+    m_bbMax = box.max;
+
+    // Check we're still over the cached ground; no query needed
+    if ( m_onGround && !landed ) {
+        m_onGround = box.min.x < m_ground.max.x && m_ground.min.x < box.max.x &&
+                     box.min.z < m_ground.max.z && m_ground.min.z < box.max.z &&
+                     box.min.y - m_ground.max.y <= 2.f * SKIN;
+
+        // Off the end of it, but maybe onto the next box at the same height;
+        // merged boxes still meet at seams. Feel just below before falling.
+        if ( !m_onGround ) {
+            glm::vec3 down( 0.f, -2.f * SKIN, 0.f );
+            for ( const CollisionBox & cb : candidates ) {
+                if ( cb.layer == LAYER_ENEMY ) continue;
+
+                float t;
+                glm::vec3 normal;
+                if ( sweepAABB( box, down, cb.box, t, normal ) && normal.y > 0.f ) {
+                    m_onGround = true;
+                    m_ground = cb.box;
+                    break;
+                }
             }
-        } else { // Z is good, use it!
-            m_location += mdNoX;
-            return true;
         }
-    } else { // no collisions: use the original vector
-        m_location += modifiedDelta;
-        return true;
     }
+
+    if ( landed || m_onGround ) {
+        m_gravity = 0;
+    } else if ( useGravity ) {
+        m_gravity -= GRAVITY_ACCELERATION;
+        if (m_gravity < TERMINAL_VELOCITY) m_gravity = TERMINAL_VELOCITY;
+    }
+    m_canJump = landed || m_onGround;
+
+    // The enemy contacting the player and the player contacting the enemy are
+    // separate cases; this is the second.
+    if ( touchedEnemy ) {
+        hurt( Enemy::DAMAGE );
+        if ( warning_timer <= 0 ) {
+            warning_timer = warning_cooldown;
+            SoundCache::getInstance()->playSound( "Assets/Laser_Shoot3.wav" );
+        }
+    }
+
+    return m_canJump;
 }
 
 double
@@ -175,23 +268,6 @@ Player::jump()
     m_canJump = false;
 }
 
-bool
-Player::updateGravity( Level * level )
-{
-    bool ret = tryToMove( glm::vec3(0, m_gravity, 0), level );
-
-    m_gravity -= GRAVITY_ACCELERATION;
-    if (m_gravity < TERMINAL_VELOCITY) m_gravity = TERMINAL_VELOCITY;
-
-    if ( !ret ) {
-        m_canJump = true;
-    } else {
-        m_canJump = false;
-    }
-
-    return !ret;
-}
-
 bool
 Player::canJump()
 const {
@@ -3,6 +3,7 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "AABB.hpp"
 #include "SceneNode.hpp"
 
 class Level;
@@ -32,6 +33,41 @@ public:
      */
     glm::mat4 getViewMatrix();
 
+    /**
+     * @brief Get the view matrix between the last two updates.
+     * @param interpolation 0 for the location before the last update, 1 for
+     *                      now.
+     * @return View matrix.
+     * @remark Only the location is blended; rotation comes straight from the
+     *         mouse so it's always the latest.
+     */
+    glm::mat4 getViewMatrix( float interpolation );
+
+    /**
+     * @brief Get the location between the last two updates.
+     * @param interpolation 0 for the location before the last update, 1 for
+     *                      now.
+     */
+    glm::vec3 getLocation( float interpolation ) const;
+
+    /** @brief Get the current view rotation; pitch in x, yaw in y. */
+    glm::vec3 getRotation() const;
+
+    /**
+     * @brief Remember the current location to draw from.
+     * @remark Call at the start of every update, before moving.
+     */
+    void savePreviousState();
+
+    /**
+     * @brief Make a view matrix for any location and rotation.
+     * @remark Lets the renderer turn the view by newer mouse movement.
+     */
+    static glm::mat4 makeViewMatrix( const glm::vec3 & location, const glm::vec3 & rotation );
+
+    /** @brief Keep pitch in bounds to prevent errors in glm::lookAt. */
+    static glm::vec3 clampRotation( glm::vec3 rotation );
+
     /**
      * @brief Rotate the player view by an additional amount.
      * @param delta The amount to rotate.
@@ -53,12 +89,18 @@ public:
     void setLocation( const glm::vec3 & loc );
 
     /**
-     * @brief Try to move the player, but only if there are no collisions.
-     * @param delta The amount to move in worldspace.
-     * @param scene The scene with which to check collision.
-     * @return true if we moved, false if there was a collision.
+     * @brief Move the player for one timestep: walking plus gravity.
+     * @param walk Where the player wants to go, relative to the direction
+     *             they're facing; y is ignored.
+     * @param level The level to collide with.
+     * @param useGravity Whether to fall.
+     * @return true if standing on the ground afterwards.
+     * @remark Kinematic move-and-slide: the whole move is swept against the
+     *         level and on contact the rest of it slides along the surface,
+     *         up to MAX_SLIDE_ITERATIONS times. The level is searched once
+     *         per call. Bumping into an enemy hurts.
      */
-    bool tryToMove( glm::vec3 delta, Level * level );
+    bool move( const glm::vec3 & walk, Level * level, bool useGravity );
 
     /**
      * @brief Get the player's movement on the Y axis.
@@ -75,14 +117,6 @@ public:
      */
     void jump();
 
-    /**
-     * @brief Updates player gravity.
-     * @param root The root node of the scene
-     * @returns true if touching the ground, false otherwise.
-     * @remark Applies gravity to player location then updates velocity.
-     */
-    bool updateGravity( Level * level );
-
     /**
      * @brief Get whether the player can jump.
      * @return true if can jump, false otherwise.
@@ -122,6 +156,10 @@ private:
     const static double GRAVITY_ACCELERATION;
     /** @brief Initial jump velocity; determines height of jump. */
     const static double JUMP_INITIAL_VELOCITY;
+    /** @brief Most surfaces a single move can slide along. */
+    const static int MAX_SLIDE_ITERATIONS;
+    /** @brief Gap kept from surfaces so sweeps never start inside them. */
+    const static float SKIN;
     /** @brief The singleton interface */
     static Player * instance;
 
@@ -134,16 +172,24 @@ private:
     glm::vec3 m_location;
     /** @brief Current player rotation; note that z not used. */
     glm::vec3 m_rotation;
+    /** @brief Location before the last update. */
+    glm::vec3 m_prevLocation;
     /** @brief The collection of player operations */
     glm::mat4 m_view;
-    /** @brief The up vector, used for generating view matrix. */
-    glm::vec3 m_up;
     /** @brief The speed at which the player moves */
     double m_speed;
     /** @brief The player's current downward force; velocity */
     double m_gravity;
     /** @brief Whether the player can jump */
     double m_canJump;
+    /** @brief Whether we're standing on m_ground. */
+    bool m_onGround;
+    /**
+     * @brief What we last landed on.
+     * @remark Kept so standing still doesn't need a query every timestep;
+     *         only static things are kept since enemies move.
+     */
+    AABB m_ground;
     /** @brief Number of timesteps before can shoot again. */
     int m_shootCooldownTimer;
     double m_health;
@@ -3,7 +3,7 @@
 #include "GlErrorCheck.hpp"
 #include "Shader.hpp"
 #include "Exception.hpp"
-#include "globals.hpp"
+#include "Profiler.hpp"
 
 PostProcess::PostProcess( const SDL_Point & dimensions,
                           int ssaa ):
@@ -71,8 +71,11 @@ PostProcess::disable()
 }
 
 void
-PostProcess::render()
+PostProcess::render( bool blur,
+                     RenderStats & stats )
 {
+    PROFILE_SCOPE( "PostProcess::render" );
+
     GLuint location;
     m_fb_shader->enable();
         // Use our texture and fullscreen quad
@@ -83,7 +86,7 @@ PostProcess::render()
         glUniform1i( location, 0 );
 
         location = m_fb_shader->getUniformLocation("postprocess_blur");
-        glUniform1i(location, postprocess_blur);
+        glUniform1i(location, blur);
         //location = m_fb_shader->getUniformLocation("width");
         //glUniform1i(location, m_dim.x);
         //location = m_fb_shader->getUniformLocation("height");
@@ -96,6 +99,14 @@ PostProcess::render()
         glDrawArrays( GL_TRIANGLES, 0, 2*3 );
     m_fb_shader->disable();
 
+    stats.programBinds++;
+    stats.textureBinds++;
+    stats.uniformUploads += 2;
+    stats.vaoBinds++;
+    stats.drawCalls++;
+    stats.vertices += 2*3;
+    stats.triangles += 2;
+
     CHECK_GL_ERRORS
 }
 
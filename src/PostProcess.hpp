@@ -8,6 +8,7 @@
 
 #include <SDL.h>
 #include "OpenGLImport.hpp"
+#include "RenderStats.hpp"
 
 class Shader;
 
@@ -34,8 +35,12 @@ public:
     /** @brief Start drawing to the screen again. */
     void disable();
 
-    /** @brief Do the post processing and display the results */
-    void render();
+    /**
+     * @brief Do the post processing and display the results
+     * @param blur Whether to blur the whole image.
+     * @param stats Counts the OpenGL calls made.
+     */
+    void render( bool blur, RenderStats & stats );
 
     /**
      * @brief Change the resolution of the post process image.
@@ -0,0 +1,307 @@
+#include "Profiler.hpp"
+
+#include <imgui.h>
+
+#include <chrono>
+#include <cstdio>
+
+// Height of one row of zones in the timeline, in pixels
+static const float TIMELINE_ROW_HEIGHT = 18.f;
+
+// Nesting depth of the zones open on this thread
+static thread_local int t_depth = 0;
+// This thread's buffer; owned by the profiler
+static thread_local void * t_buffer = nullptr;
+
+static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+Profiler * Profiler::instance = nullptr;
+std::atomic<bool> Profiler::s_enabled( false );
+
+Profiler *
+Profiler::getInstance()
+{
+    if ( instance == nullptr ) instance = new Profiler();
+    return instance;
+}
+
+void
+Profiler::cleanup()
+{
+    s_enabled = false;
+    delete instance;
+    instance = nullptr;
+}
+
+Profiler::Profiler():
+    m_threadsMutex(),
+    m_threads(),
+    m_frameZones(),
+    m_samplesMutex(),
+    m_samples(),
+    m_frameStart( now() ),
+    m_frameEnd( m_frameStart ),
+    m_dropped(0),
+    m_stats()
+{
+    // nothing else to do
+}
+
+void
+Profiler::setEnabled( bool enabled )
+{
+    s_enabled = enabled;
+}
+
+std::uint64_t
+Profiler::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - epoch ).count();
+}
+
+void
+Profiler::setThreadName( const std::string & name )
+{
+    ThreadBuffer & buffer = getThreadBuffer();
+    std::lock_guard<std::mutex> lock( buffer.mutex );
+    buffer.name = name;
+}
+
+void
+Profiler::addZone( const char * name,
+                   std::uint64_t start,
+                   std::uint64_t end,
+                   int depth )
+{
+    ThreadBuffer & buffer = getThreadBuffer();
+    ProfileZone zone = { name, start, end, depth, 0 };
+
+    // Only beginFrame() ever waits on this, once a frame
+    std::lock_guard<std::mutex> lock( buffer.mutex );
+    buffer.ring[buffer.written % RING_SIZE] = zone;
+    buffer.written++;
+}
+
+void
+Profiler::addSample( const char * name,
+                     float milliseconds )
+{
+    if ( !isEnabled() ) return;
+
+    std::lock_guard<std::mutex> lock( m_samplesMutex );
+    m_samples.push_back( std::make_pair( name, milliseconds ) );
+}
+
+void
+Profiler::beginFrame()
+{
+    m_frameStart = m_frameEnd;
+    m_frameEnd = now();
+    m_frameZones.clear();
+
+    std::lock_guard<std::mutex> threadsLock( m_threadsMutex );
+    for ( std::size_t i = 0; i < m_threads.size(); i++ ) {
+        ThreadBuffer & buffer = *m_threads[i];
+        std::lock_guard<std::mutex> lock( buffer.mutex );
+
+        if ( buffer.written - buffer.read > RING_SIZE ) {
+            m_dropped += buffer.written - buffer.read - RING_SIZE;
+            buffer.read = buffer.written - RING_SIZE;
+        }
+
+        for ( ; buffer.read < buffer.written; buffer.read++ ) {
+            ProfileZone zone = buffer.ring[buffer.read % RING_SIZE];
+            zone.thread = i;
+            m_frameZones.push_back( zone );
+        }
+    }
+
+    updateStats();
+}
+
+const std::vector<ProfileZone> &
+Profiler::getFrameZones()
+const {
+    return m_frameZones;
+}
+
+std::uint64_t
+Profiler::getFrameStart()
+const {
+    return m_frameStart;
+}
+
+std::uint64_t
+Profiler::getFrameEnd()
+const {
+    return m_frameEnd;
+}
+
+int
+Profiler::getThreadCount()
+const {
+    std::lock_guard<std::mutex> lock( m_threadsMutex );
+    return m_threads.size();
+}
+
+std::string
+Profiler::getThreadName( int thread )
+const {
+    std::lock_guard<std::mutex> threadsLock( m_threadsMutex );
+    ThreadBuffer & buffer = *m_threads[thread];
+    std::lock_guard<std::mutex> lock( buffer.mutex );
+    return buffer.name;
+}
+
+void
+Profiler::drawWindow( bool * open )
+{
+    ImGui::SetNextWindowSize( ImVec2( 640, 400 ), ImGuiSetCond_FirstUseEver );
+    if ( !ImGui::Begin( "Profiler", open ) ) {
+        ImGui::End();
+        return;
+    }
+
+    bool enabled = isEnabled();
+    if ( ImGui::Checkbox( "Record", &enabled ) ) setEnabled( enabled );
+    ImGui::SameLine();
+    double frameLength = ( m_frameEnd - m_frameStart ) / 1e6;
+    ImGui::Text( "Frame: %.2f ms, %d zones, %llu dropped", frameLength, (int)m_frameZones.size(), (unsigned long long)m_dropped );
+
+    // Timeline: one band per thread, one row per nesting depth
+    int threadCount = getThreadCount();
+    std::vector<int> depths( threadCount, -1 );
+    for ( const ProfileZone & zone : m_frameZones ) {
+        if ( zone.depth > depths[zone.thread] ) depths[zone.thread] = zone.depth;
+    }
+
+    ImDrawList * draw = ImGui::GetWindowDrawList();
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    float width = ImGui::GetContentRegionAvailWidth();
+    double scale = m_frameEnd > m_frameStart ? width / (double)( m_frameEnd - m_frameStart ) : 0.0;
+    float y = origin.y;
+
+    for ( int t = 0; t < threadCount; t++ ) {
+        if ( depths[t] < 0 ) continue;
+
+        std::string name = getThreadName( t );
+        draw->AddText( ImVec2( origin.x, y ), ImColor( 200, 200, 200 ), name.c_str() );
+        y += TIMELINE_ROW_HEIGHT;
+
+        for ( const ProfileZone & zone : m_frameZones ) {
+            if ( zone.thread != t ) continue;
+
+            // Zones that started before the frame are cut off at its start
+            std::uint64_t start = zone.start > m_frameStart ? zone.start : m_frameStart;
+            float x0 = origin.x + ( start - m_frameStart ) * scale;
+            float x1 = origin.x + ( zone.end - m_frameStart ) * scale;
+            if ( x1 < x0 + 1.f ) x1 = x0 + 1.f;
+            ImVec2 a( x0, y + zone.depth * TIMELINE_ROW_HEIGHT );
+            ImVec2 b( x1, a.y + TIMELINE_ROW_HEIGHT - 1.f );
+
+            // Same name, same color, frame to frame
+            unsigned hash = 2166136261u;
+            for ( const char * c = zone.name; *c; c++ ) hash = ( hash ^ *c ) * 16777619u;
+            draw->AddRectFilled( a, b, ImColor::HSV( ( hash % 360 ) / 360.f, 0.6f, 0.7f ) );
+
+            if ( ImGui::CalcTextSize( zone.name ).x < x1 - x0 - 4.f ) {
+                draw->AddText( ImVec2( x0 + 2.f, a.y + 1.f ), ImColor( 255, 255, 255 ), zone.name );
+            }
+            if ( ImGui::IsMouseHoveringRect( a, b ) ) {
+                ImGui::SetTooltip( "%s: %.3f ms", zone.name, ( zone.end - zone.start ) / 1e6 );
+            }
+        }
+        y += ( depths[t] + 1 ) * TIMELINE_ROW_HEIGHT;
+    }
+    ImGui::Dummy( ImVec2( width, y - origin.y ) );
+
+    // Rolling statistics
+    ImGui::Separator();
+    ImGui::Columns( 4, "ProfilerStats" );
+    ImGui::Text( "Zone" ); ImGui::NextColumn();
+    ImGui::Text( "Last (ms)" ); ImGui::NextColumn();
+    ImGui::Text( "Average (ms)" ); ImGui::NextColumn();
+    ImGui::Text( "Max (ms)" ); ImGui::NextColumn();
+    ImGui::Separator();
+    for ( const std::pair<const std::string, std::deque<float>> & entry : m_stats ) {
+        const std::deque<float> & frames = entry.second;
+        float sum = 0.f;
+        float max = 0.f;
+        for ( float ms : frames ) {
+            sum += ms;
+            if ( ms > max ) max = ms;
+        }
+
+        ImGui::Text( "%s", entry.first.c_str() ); ImGui::NextColumn();
+        ImGui::Text( "%.3f", frames.back() ); ImGui::NextColumn();
+        ImGui::Text( "%.3f", sum / frames.size() ); ImGui::NextColumn();
+        ImGui::Text( "%.3f", max ); ImGui::NextColumn();
+    }
+    ImGui::Columns( 1 );
+
+    ImGui::End();
+}
+
+Profiler::ThreadBuffer &
+Profiler::getThreadBuffer()
+{
+    if ( t_buffer == nullptr ) {
+        std::lock_guard<std::mutex> lock( m_threadsMutex );
+        ThreadBuffer * buffer = new ThreadBuffer();
+        buffer->ring.resize( RING_SIZE );
+        buffer->written = 0;
+        buffer->read = 0;
+
+        char name[32];
+        snprintf( name, 32, "Thread %d", (int)m_threads.size() );
+        buffer->name = name;
+
+        m_threads.push_back( std::unique_ptr<ThreadBuffer>( buffer ) );
+        t_buffer = buffer;
+    }
+    return *(ThreadBuffer *)t_buffer;
+}
+
+void
+Profiler::updateStats()
+{
+    if ( !isEnabled() ) return;
+
+    std::map<std::string, float> totals;
+    for ( const ProfileZone & zone : m_frameZones ) {
+        totals[zone.name] += ( zone.end - zone.start ) / 1e6f;
+    }
+    {
+        std::lock_guard<std::mutex> lock( m_samplesMutex );
+        for ( const std::pair<const char *, float> & sample : m_samples ) {
+            totals[sample.first] += sample.second;
+        }
+        m_samples.clear();
+    }
+
+    // Names missing this frame count as 0 so averages stay per frame
+    for ( std::pair<const std::string, std::deque<float>> & entry : m_stats ) {
+        if ( totals.find( entry.first ) == totals.end() ) totals[entry.first] = 0.f;
+    }
+
+    for ( const std::pair<const std::string, float> & total : totals ) {
+        std::deque<float> & frames = m_stats[total.first];
+        frames.push_back( total.second );
+        if ( (int)frames.size() > STATS_FRAMES ) frames.pop_front();
+    }
+}
+
+void
+ProfileScope::begin()
+{
+    m_active = true;
+    m_start = Profiler::now();
+    t_depth++;
+}
+
+void
+ProfileScope::end()
+{
+    t_depth--;
+    Profiler::getInstance()->addZone( m_name, m_start, Profiler::now(), t_depth );
+}
@@ -0,0 +1,211 @@
+/**
+ * @file Profiler.hpp
+ * @brief Interface for Profiler
+ * @author Michael Hitchens
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Time the rest of the enclosing scope as a zone called name.
+ * @param name A string literal; only the pointer is kept.
+ * @remark Costs one relaxed load and a branch while the profiler is off.
+ *         Define NO_PROFILER to compile zones out entirely.
+ */
+#ifdef NO_PROFILER
+    #define PROFILE_SCOPE(name)
+#else
+    #define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)( name )
+#endif
+
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_CONCAT_INNER(a, b) a##b
+
+/**
+ * @brief One timed piece of work on one thread.
+ */
+struct ProfileZone {
+    /** @brief A string literal naming the zone. */
+    const char * name;
+    /** @brief Nanoseconds since the profiler started. */
+    std::uint64_t start;
+    std::uint64_t end;
+    /** @brief How many zones it's nested in on its thread; 0 for outermost. */
+    int depth;
+    /** @brief Index of the thread it ran on; see getThreadName(). */
+    int thread;
+};
+
+/**
+ * @brief Collects zones from every thread and shows them a frame at a time.
+ * @details Each thread writes finished zones into a ring buffer of its own.
+ *          Once a frame, beginFrame() drains every ring into one list of the
+ *          zones that finished during the last frame, and adds them to the
+ *          rolling statistics. A ring only holds so many zones; if a thread
+ *          makes more than that in one frame the oldest are dropped.
+ * @remark Zones from the render thread show up in the frame they finished
+ *         in, which is usually a frame after the update that made them.
+ * @remark Singleton!
+ */
+class Profiler {
+public:
+    /**
+     * @brief Get the singleton instance.
+     * @remark Lazy inits the instance.
+     */
+    static Profiler * getInstance();
+
+    /** @brief Delete the singleton instance. */
+    static void cleanup();
+
+    /** @brief Get whether zones are being recorded; checked by every zone. */
+    static bool isEnabled();
+
+    /** @brief Start or stop recording zones. Off to begin with. */
+    void setEnabled( bool enabled );
+
+    /** @brief Get the time in nanoseconds since the profiler started. */
+    static std::uint64_t now();
+
+    /** @brief Name the calling thread in the timeline. */
+    void setThreadName( const std::string & name );
+
+    /** @brief Record a finished zone on the calling thread. */
+    void addZone( const char * name, std::uint64_t start, std::uint64_t end, int depth );
+
+    /**
+     * @brief Add a time to a zone's statistics without it being a zone.
+     * @details For times measured some other way, like on the GPU, which
+     *          have no place on the timeline.
+     * @param name A string literal.
+     * @remark Any thread. Ignored while the profiler is off.
+     */
+    void addSample( const char * name, float milliseconds );
+
+    /**
+     * @brief Close the last frame and start a new one.
+     * @remark Main thread only, once per frame.
+     */
+    void beginFrame();
+
+    /** @brief Get the zones that finished during the last frame. */
+    const std::vector<ProfileZone> & getFrameZones() const;
+
+    /** @brief Get when the last frame started, in nanoseconds. */
+    std::uint64_t getFrameStart() const;
+
+    /** @brief Get when the last frame ended, in nanoseconds. */
+    std::uint64_t getFrameEnd() const;
+
+    /** @brief Get the number of threads that have made zones or names. */
+    int getThreadCount() const;
+
+    std::string getThreadName( int thread ) const;
+
+    /**
+     * @brief Show the last frame as a timeline plus per zone statistics.
+     * @param open Set to false when the window is closed.
+     */
+    void drawWindow( bool * open );
+
+private:
+    /** @brief Zones a thread can make between two frames. */
+    static const int RING_SIZE = 8192;
+    /** @brief Frames averaged over for the statistics. */
+    static const int STATS_FRAMES = 120;
+
+    /** @brief One thread's recent zones. */
+    struct ThreadBuffer {
+        std::mutex mutex;
+        std::vector<ProfileZone> ring;
+        /** @brief Zones ever written; the next goes at written % RING_SIZE. */
+        std::uint64_t written;
+        /** @brief Zones ever drained by beginFrame(). */
+        std::uint64_t read;
+        std::string name;
+    };
+
+    static Profiler * instance;
+    static std::atomic<bool> s_enabled;
+
+    Profiler();
+
+    /** @brief Get the calling thread's buffer, making it on first use. */
+    ThreadBuffer & getThreadBuffer();
+
+    /** @brief Add the last frame's zone times to m_stats. */
+    void updateStats();
+
+    /** @brief Guards m_threads; not the buffers in it. */
+    mutable std::mutex m_threadsMutex;
+    /** @brief Thread i's buffer is m_threads[i]; never shrinks. */
+    std::vector<std::unique_ptr<ThreadBuffer>> m_threads;
+
+    std::vector<ProfileZone> m_frameZones;
+    std::mutex m_samplesMutex;
+    /** @brief Samples added since the last beginFrame(). */
+    std::vector<std::pair<const char *, float>> m_samples;
+    std::uint64_t m_frameStart;
+    std::uint64_t m_frameEnd;
+    /** @brief Zones lost to full rings since the profiler started. */
+    std::uint64_t m_dropped;
+    /** @brief Total milliseconds per frame for each zone name, oldest first. */
+    std::map<std::string, std::deque<float>> m_stats;
+};
+
+/**
+ * @brief Times its own lifetime; use PROFILE_SCOPE rather than this.
+ */
+class ProfileScope {
+public:
+    explicit ProfileScope( const char * name );
+    ~ProfileScope();
+
+private:
+    ProfileScope( const ProfileScope & );
+    ProfileScope & operator=( const ProfileScope & );
+
+    /** @brief Start timing; only called while the profiler is on. */
+    void begin();
+
+    /** @brief Stop timing and record the zone. */
+    void end();
+
+    const char * m_name;
+    std::uint64_t m_start;
+    /** @brief Whether the profiler was on when we started. */
+    bool m_active;
+};
+
+// Inline so a zone costs a single branch while the profiler is off
+
+inline bool
+Profiler::isEnabled()
+{
+    return s_enabled.load( std::memory_order_relaxed );
+}
+
+inline
+ProfileScope::ProfileScope( const char * name ):
+    m_name( name ),
+    m_start(0),
+    m_active(false)
+{
+    if ( Profiler::isEnabled() ) begin();
+}
+
+inline
+ProfileScope::~ProfileScope()
+{
+    if ( m_active ) end();
+}
@@ -0,0 +1,62 @@
+#include "RenderSnapshot.hpp"
+
+#include <cstring>
+
+/** @brief Copy an ImVector of plain data; ImVector has no copy constructor. */
+template <typename T>
+static void
+copyVector( ImVector<T> & dst,
+            const ImVector<T> & src )
+{
+    dst.resize( src.Size );
+    if ( src.Size > 0 ) memcpy( dst.Data, src.Data, src.Size * sizeof( T ) );
+}
+
+GuiDrawData::GuiDrawData():
+    m_lists(),
+    m_data()
+{
+    // nothing else to do
+}
+
+GuiDrawData::~GuiDrawData()
+{
+    for ( ImDrawList * list : m_lists ) {
+        delete list;
+    }
+}
+
+void
+GuiDrawData::copy( const ImDrawData * data )
+{
+    int count = ( data && data->Valid ) ? data->CmdListsCount : 0;
+    while ( (int)m_lists.size() < count ) {
+        m_lists.push_back( new ImDrawList() );
+    }
+
+    for ( int i = 0; i < count; i++ ) {
+        const ImDrawList * src = data->CmdLists[i];
+        copyVector( m_lists[i]->CmdBuffer, src->CmdBuffer );
+        copyVector( m_lists[i]->IdxBuffer, src->IdxBuffer );
+        copyVector( m_lists[i]->VtxBuffer, src->VtxBuffer );
+    }
+
+    m_data.Valid = count > 0;
+    m_data.CmdLists = count > 0 ? &m_lists[0] : nullptr;
+    m_data.CmdListsCount = count;
+    m_data.TotalVtxCount = count > 0 ? data->TotalVtxCount : 0;
+    m_data.TotalIdxCount = count > 0 ? data->TotalIdxCount : 0;
+}
+
+ImDrawData *
+GuiDrawData::get()
+{
+    return &m_data;
+}
+
+void
+RenderSnapshot::clear()
+{
+    lights.clear();
+    items.clear();
+}
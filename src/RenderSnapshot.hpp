@@ -0,0 +1,117 @@
+/**
+ * @file RenderSnapshot.hpp
+ * @brief Interface for RenderSnapshot
+ * @author Michael Hitchens
+ */
+
+#pragma once
+
+#include "FramePacer.hpp"
+#include "Light.hpp"
+
+#include <SDL.h>
+#include <glm/glm.hpp>
+#include <imgui.h>
+
+#include <vector>
+
+// forward decls
+class Model;
+class Material;
+
+/**
+ * @brief One model to draw.
+ */
+struct DrawItem {
+    Model * model;
+    /** @brief Keyframe to draw; blends towards the one after it. */
+    int keyframe;
+    /** @brief How far towards the next keyframe, in [0, 1). */
+    float blend;
+    Material * material;
+    /** @brief Model to world transform. */
+    glm::mat4 M;
+    float alpha;
+};
+
+/**
+ * @brief Switches from the options menu that change how things are drawn.
+ */
+struct RenderSettings {
+    bool normalMapping;
+    bool specularMapping;
+    bool textureMapping;
+    bool selfIllumination;
+    bool showNormals;
+    bool useLights;
+    /** @brief Blur the whole screen, e.g. on the game over screen. */
+    bool blur;
+};
+
+/**
+ * @brief Where the camera was when the frame was made.
+ * @details The renderer rebuilds V from this just before uploading it, turned
+ *          by any mouse movement since, so looking around feels immediate no
+ *          matter how long the frame took to make.
+ */
+struct CameraState {
+    glm::vec3 location;
+    glm::vec3 rotation;
+    /** @brief MouseLook total already included in rotation. */
+    glm::ivec2 lookTotal;
+    /** @brief Whether the mouse turns the camera; if not V is used as is. */
+    bool lateLatch;
+};
+
+/**
+ * @brief A copy of the GUI draw lists for one frame.
+ * @details ImGui reuses its draw lists every frame, so they're copied out
+ *          before the next frame starts building new ones.
+ */
+class GuiDrawData {
+public:
+    GuiDrawData();
+    ~GuiDrawData();
+
+    /** @brief Replace the copy with what ImGui::Render() just made. */
+    void copy( const ImDrawData * data );
+
+    /** @brief Get the copy in the form the ImGui renderer takes. */
+    ImDrawData * get();
+
+private:
+    // Owns ImDrawLists
+    GuiDrawData( const GuiDrawData & );
+    GuiDrawData & operator=( const GuiDrawData & );
+
+    /** @brief Kept between frames so their buffers get reused. */
+    std::vector<ImDrawList *> m_lists;
+    ImDrawData m_data;
+};
+
+/**
+ * @brief Everything needed to draw one frame, copied out of the game.
+ * @details The simulation fills one in at the end of an update and hands it
+ *          to the Renderer. After that the snapshot is only read, so the
+ *          renderer can draw it on another thread while the next update runs.
+ * @remark Models and materials are referenced, not copied; they're loaded
+ *         before the game starts and never change.
+ */
+struct RenderSnapshot {
+    glm::mat4 V;
+    glm::mat4 P;
+    CameraState camera;
+    /** @brief Window size when the frame was made. */
+    SDL_Point windowDim;
+    glm::vec3 ambient;
+    std::vector<Light> lights;
+    /** @brief In draw order; opaque things first, translucent back to front. */
+    std::vector<DrawItem> items;
+    RenderSettings settings;
+    GuiDrawData gui;
+    /** @brief Main thread timings; the renderer fills in the rest. */
+    FrameTimings timings;
+
+    /** @brief Empty the lists but keep their memory. */
+    void clear();
+};
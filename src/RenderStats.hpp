@@ -0,0 +1,57 @@
+/**
+ * @file RenderStats.hpp
+ * @brief Counters for how much work a frame asks of OpenGL and the scene.
+ * @author Michael Hitchens
+ */
+
+#pragma once
+
+/**
+ * @brief What the renderer sent to OpenGL for one frame.
+ * @details Counted where the calls are made, so passes can be compared
+ *          before and after an optimisation.
+ */
+struct RenderStats {
+    int drawCalls;
+    int vertices;
+    int triangles;
+    /** @brief glUseProgram calls. */
+    int programBinds;
+    /** @brief glBindVertexArray calls. */
+    int vaoBinds;
+    /** @brief glBindTexture calls. */
+    int textureBinds;
+    /** @brief glUniform* calls. */
+    int uniformUploads;
+};
+
+/**
+ * @brief How many of each kind of thing the level holds right now.
+ */
+struct SceneStats {
+    /** @brief Level scenery. */
+    int staticGeometry;
+    /** @brief Scenery that animates; counted in staticGeometry too. */
+    int animatedGeometry;
+    /** @brief Static collision boxes, after merging. */
+    int staticBoxes;
+    /** @brief Static collision boxes before merging. */
+    int unmergedStaticBoxes;
+    /** @brief Flow field size in cells. */
+    int flowFieldWidth;
+    int flowFieldDepth;
+    int blockedFlowCells;
+    /** @brief Live entities in the level's World: enemies, bullets and particles. */
+    int entities;
+
+    // Components of each kind in the World
+    int transforms;
+    int velocities;
+    int lifetimes;
+    int healths;
+    int meshes;
+    int colliders;
+    int emitters;
+    int animations;
+    int enemies;
+};
@@ -0,0 +1,367 @@
+#include "Renderer.hpp"
+
+#include "GlErrorCheck.hpp"
+#include "Material.hpp"
+#include "Model.hpp"
+#include "MouseLook.hpp"
+#include "Player.hpp"
+#include "PostProcess.hpp"
+#include "Profiler.hpp"
+#include "Shader.hpp"
+
+#include <imgui_impl_sdl_gl3.h>
+
+#include <cstdio>
+
+Renderer::Renderer( SDL_Window * window,
+                    SDL_GLContext context,
+                    Shader * shader,
+                    PostProcess * postprocess,
+                    bool threaded ):
+    m_drawGui( ImGui::GetIO().RenderDrawListsFn ),
+    m_window( window ),
+    m_context( context ),
+    m_shader( shader ),
+    m_postprocess( postprocess ),
+    m_pacer(),
+    m_gpuTimer(),
+    m_look(nullptr),
+    m_dim(),
+    m_snapshots(),
+    m_writing(0),
+    m_ready(-1),
+    m_drawing(-1),
+    m_threaded( threaded ),
+    m_quit(false),
+    m_thread(),
+    m_mutex(),
+    m_changed(),
+    m_guiMutex(),
+    m_statsMutex(),
+    m_stats()
+{
+    SDL_GetWindowSize( window, &m_dim.x, &m_dim.y );
+
+    // The GUI is drawn here from a copy of its draw lists instead
+    ImGui::GetIO().RenderDrawListsFn = nullptr;
+
+    if ( m_threaded ) {
+        // A context can only be current on one thread at a time
+        SDL_GL_MakeCurrent( m_window, nullptr );
+        m_thread = std::thread( &Renderer::renderLoop, this );
+    }
+}
+
+Renderer::~Renderer()
+{
+    if ( m_threaded ) {
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_quit = true;
+        }
+        m_changed.notify_all();
+        m_thread.join();
+
+        SDL_GL_MakeCurrent( m_window, m_context );
+    }
+    m_pacer.releaseGpu();
+    m_gpuTimer.releaseGpu();
+
+    ImGui::GetIO().RenderDrawListsFn = m_drawGui;
+}
+
+RenderSnapshot &
+Renderer::getSnapshot()
+{
+    return m_snapshots[m_writing];
+}
+
+void
+Renderer::submit()
+{
+    if ( !m_threaded ) {
+        draw( m_snapshots[m_writing] );
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock( m_mutex );
+
+    // Stay at most one frame ahead; the game still counts time in updates
+    m_changed.wait( lock, [this]() { return m_ready < 0; } );
+    m_ready = m_writing;
+
+    // With three snapshots there's always one neither waiting nor being drawn
+    for ( int i = 0; i < SNAPSHOT_COUNT; i++ ) {
+        if ( i != m_ready && i != m_drawing ) {
+            m_writing = i;
+            break;
+        }
+    }
+
+    lock.unlock();
+    m_changed.notify_all();
+}
+
+void
+Renderer::beginGuiFrame()
+{
+    std::lock_guard<std::mutex> lock( m_guiMutex );
+    ImGui_ImplSdlGL3_NewFrame();
+}
+
+bool
+Renderer::isThreaded()
+const {
+    return m_threaded;
+}
+
+FramePacer &
+Renderer::getFramePacer()
+{
+    return m_pacer;
+}
+
+RenderStats
+Renderer::getLastStats()
+const {
+    std::lock_guard<std::mutex> lock( m_statsMutex );
+    return m_stats;
+}
+
+void
+Renderer::setMouseLook( const MouseLook * look )
+{
+    m_look = look;
+}
+
+void
+Renderer::renderLoop()
+{
+    Profiler::getInstance()->setThreadName( "Render" );
+    SDL_GL_MakeCurrent( m_window, m_context );
+
+    while ( true ) {
+        int index;
+        {
+            std::unique_lock<std::mutex> lock( m_mutex );
+            m_changed.wait( lock, [this]() { return m_quit || m_ready >= 0; } );
+            if ( m_quit ) break;
+
+            index = m_ready;
+            m_drawing = index;
+            m_ready = -1;
+        }
+        m_changed.notify_all();
+
+        draw( m_snapshots[index] );
+
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_drawing = -1;
+    }
+
+    SDL_GL_MakeCurrent( m_window, nullptr );
+}
+
+void
+Renderer::draw( RenderSnapshot & frame )
+{
+    PROFILE_SCOPE( "Renderer::draw" );
+
+    FrameTimings timings = frame.timings;
+    {
+        PROFILE_SCOPE( "Wait for GPU" );
+        timings.gpuWait = m_pacer.waitForGpu();
+    }
+    m_gpuTimer.beginFrame();
+    RenderStats stats = RenderStats();
+    Uint64 renderStart = SDL_GetPerformanceCounter();
+
+    // Since frame buffer targets are resolution dependent we must update them.
+    if ( frame.windowDim.x != m_dim.x || frame.windowDim.y != m_dim.y ) {
+        m_dim = frame.windowDim;
+        m_postprocess->changeResolution( m_dim );
+    }
+
+    // TODO do we need to call these every timestep?
+    glClearColor( 0.1, 0.1, 0.1, 1.0 );
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    // step 1: draw to framebuffer
+    m_gpuTimer.begin( GpuTimer::SCENE );
+    m_postprocess->enable();
+    m_shader->enable();
+    stats.programBinds++;
+        drawScene( frame, stats );
+    m_shader->disable();
+    m_postprocess->disable();
+    m_gpuTimer.end( GpuTimer::SCENE );
+
+    // step 2: draw this to the screen
+    glViewport(0, 0, m_dim.x, m_dim.y);
+    glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+
+    m_gpuTimer.begin( GpuTimer::POSTPROCESS );
+    m_postprocess->render( frame.settings.blur, stats );
+    m_gpuTimer.end( GpuTimer::POSTPROCESS );
+
+    // step 3: draw gui
+    // we do this last to not interfere with post process
+    {
+        std::lock_guard<std::mutex> lock( m_guiMutex );
+        m_gpuTimer.begin( GpuTimer::GUI );
+        if ( m_drawGui ) m_drawGui( frame.gui.get() );
+        m_gpuTimer.end( GpuTimer::GUI );
+    }
+    if ( m_drawGui ) countGui( frame.gui.get(), stats );
+
+    Uint64 presentStart = SDL_GetPerformanceCounter();
+    {
+        PROFILE_SCOPE( "Present" );
+        SDL_GL_SwapWindow( m_window );
+    }
+    m_pacer.endGpuFrame();
+    CHECK_GL_ERRORS;
+
+    Uint64 presentEnd = SDL_GetPerformanceCounter();
+    timings.render = FramePacer::getMilliseconds( renderStart, presentStart );
+    timings.present = FramePacer::getMilliseconds( presentStart, presentEnd );
+    timings.gpuScene = m_gpuTimer.getMilliseconds( GpuTimer::SCENE );
+    timings.gpuPostProcess = m_gpuTimer.getMilliseconds( GpuTimer::POSTPROCESS );
+    timings.gpuGui = m_gpuTimer.getMilliseconds( GpuTimer::GUI );
+    m_pacer.addTimings( timings );
+
+    {
+        std::lock_guard<std::mutex> lock( m_statsMutex );
+        m_stats = stats;
+    }
+
+    Profiler * profiler = Profiler::getInstance();
+    for ( int pass = 0; pass < GpuTimer::PASS_COUNT; pass++ ) {
+        profiler->addSample( GpuTimer::getPassName( (GpuTimer::Pass)pass ), m_gpuTimer.getMilliseconds( (GpuTimer::Pass)pass ) );
+    }
+}
+
+void
+Renderer::drawScene( RenderSnapshot & frame,
+                     RenderStats & stats )
+{
+    PROFILE_SCOPE( "Renderer::drawScene" );
+
+    GLuint location;
+
+    // Late latch: the mouse has likely moved since the frame was made
+    glm::mat4 V = frame.V;
+    const CameraState & camera = frame.camera;
+    if ( m_look && camera.lateLatch ) {
+        glm::ivec2 motion = m_look->getTotal() - camera.lookTotal;
+        glm::vec3 rotation = Player::clampRotation( camera.rotation + MouseLook::toRotation( motion ) );
+        V = Player::makeViewMatrix( camera.location, rotation );
+    }
+
+    location = m_shader->getUniformLocation("V");
+    glUniformMatrix4fv( location, 1, GL_FALSE, &V[0][0] );
+    location = m_shader->getUniformLocation("P");
+    glUniformMatrix4fv( location, 1, GL_FALSE, &frame.P[0][0] );
+    stats.uniformUploads += 2;
+
+    Material::updateTextureUniforms( m_shader, stats );
+
+    const RenderSettings & settings = frame.settings;
+    location = m_shader->getUniformLocation("use_normal_mapping");
+    glUniform1i(location, settings.normalMapping);
+    location = m_shader->getUniformLocation("use_specular_mapping");
+    glUniform1i(location, settings.specularMapping);
+    location = m_shader->getUniformLocation("use_texture_mapping");
+    glUniform1i(location, settings.textureMapping);
+    location = m_shader->getUniformLocation("debug_show_normals");
+    glUniform1i(location, settings.showNormals);
+    location = m_shader->getUniformLocation("debug_use_lights");
+    glUniform1i(location, settings.useLights);
+    location = m_shader->getUniformLocation("use_self_illumination");
+    glUniform1i(location, settings.selfIllumination);
+
+    location = m_shader->getUniformLocation("k_a");
+    glUniform3f(location, frame.ambient.x, frame.ambient.y, frame.ambient.z);
+    stats.uniformUploads += 7;
+
+    for ( std::size_t i = 0; i < frame.lights.size(); i++ ) {
+        const Light & light = frame.lights[i];
+        char uniformString[32];
+
+        snprintf( uniformString, 32, "LightColor[%d]", (int)i );
+        location = m_shader->getUniformLocation(uniformString);
+        glUniform3f( location, light.intensity.r, light.intensity.g, light.intensity.b );
+
+        snprintf( uniformString, 32, "LightPosition_WS[%d]", (int)i );
+        location = m_shader->getUniformLocation(uniformString);
+        glUniform3f( location, light.position.x, light.position.y, light.position.z );
+
+        snprintf( uniformString, 32, "LightPower[%d]", (int)i );
+        location = m_shader->getUniformLocation(uniformString);
+        glUniform1f( location, light.power );
+        stats.uniformUploads += 3;
+    }
+
+    location = m_shader->getUniformLocation("numLights");
+    glUniform1i( location, frame.lights.size() );
+    stats.uniformUploads++;
+
+    GLuint locationM = m_shader->getUniformLocation("M");
+    GLuint locationBlend = m_shader->getUniformLocation("blend");
+    GLuint locationAlpha = m_shader->getUniformLocation("alpha");
+
+    // Items come sorted by model and material, so most binds can be skipped
+    Material * boundMaterial = nullptr;
+    GLuint boundVao = 0;
+    for ( const DrawItem & item : frame.items ) {
+        glUniformMatrix4fv( locationM, 1, GL_FALSE, &item.M[0][0] );
+        glUniform1f( locationBlend, item.blend );
+        glUniform1f( locationAlpha, item.alpha );
+        stats.uniformUploads += 3;
+
+        if ( item.material != boundMaterial ) {
+            item.material->bind( m_shader, stats );
+            boundMaterial = item.material;
+        }
+
+        GLuint vao = item.model->getVertexArray( item.keyframe );
+        if ( vao != boundVao ) {
+            glBindVertexArray( vao );
+            boundVao = vao;
+            stats.vaoBinds++;
+        }
+        int vertices = item.model->getVertexCount();
+        glDrawArrays( GL_TRIANGLES, 0, vertices );
+        stats.drawCalls++;
+        stats.vertices += vertices;
+        stats.triangles += vertices / 3;
+    }
+
+    glBindVertexArray( 0 );
+    CHECK_GL_ERRORS;
+}
+
+void
+Renderer::countGui( const ImDrawData * data,
+                    RenderStats & stats )
+{
+    // What the ImGui example binding does with the lists: one program and
+    // VAO, a projection and texture uniform, then a draw per command
+    stats.programBinds++;
+    stats.vaoBinds++;
+    stats.uniformUploads += 2;
+
+    for ( int i = 0; i < data->CmdListsCount; i++ ) {
+        const ImDrawList * list = data->CmdLists[i];
+        stats.vertices += list->VtxBuffer.size();
+        for ( const ImDrawCmd & cmd : list->CmdBuffer ) {
+            if ( cmd.UserCallback ) continue;
+            stats.drawCalls++;
+            stats.textureBinds++;
+            stats.triangles += cmd.ElemCount / 3;
+        }
+    }
+}
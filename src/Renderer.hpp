@@ -0,0 +1,132 @@
+/**
+ * @file Renderer.hpp
+ * @brief Interface for Renderer
+ * @author Michael Hitchens
+ */
+
+#pragma once
+
+#include "FramePacer.hpp"
+#include "GpuTimer.hpp"
+#include "RenderSnapshot.hpp"
+#include "RenderStats.hpp"
+
+#include <SDL.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+class Shader;
+class PostProcess;
+class MouseLook;
+
+/**
+ * @brief Draws render snapshots, usually on a thread of its own.
+ * @details The simulation fills in getSnapshot() and calls submit(). With a
+ *          render thread, submit() returns as soon as the thread has taken the
+ *          previous frame, so the next update runs while this frame is drawn.
+ *          A frame takes max(update, draw) instead of update + draw.
+ * @details Three snapshots rotate: one being drawn, one waiting, and one being
+ *          filled. Only the renderer makes OpenGL calls once it is created.
+ * @remark Without a render thread everything is drawn inside submit(), which
+ *         is handy for debugging.
+ */
+class Renderer {
+public:
+    /**
+     * @brief Take over the OpenGL context.
+     * @param window The window to draw to.
+     * @param context The window's context; current on the calling thread.
+     * @param shader The shader used to draw the scene.
+     * @param postprocess Where the scene is drawn before the screen.
+     * @param threaded Whether to draw on a thread of its own.
+     * @remark Everything the snapshots refer to must already be uploaded,
+     *         including the GUI's device objects.
+     */
+    Renderer( SDL_Window * window, SDL_GLContext context, Shader * shader, PostProcess * postprocess, bool threaded );
+
+    /** @brief Stop drawing and make the context current on the caller again. */
+    ~Renderer();
+
+    /**
+     * @brief Get the snapshot to fill in for the next frame.
+     * @remark Stays the same until submit() is called.
+     */
+    RenderSnapshot & getSnapshot();
+
+    /** @brief Hand the filled snapshot over to be drawn. */
+    void submit();
+
+    /**
+     * @brief Start a new GUI frame.
+     * @remark Use this instead of ImGui_ImplSdlGL3_NewFrame; the GUI renderer
+     *         reads the display size that it sets.
+     */
+    void beginGuiFrame();
+
+    bool isThreaded() const;
+
+    /** @brief Get the pacing settings and frame timings. */
+    FramePacer & getFramePacer();
+
+    /** @brief Get what the last frame shown sent to OpenGL. */
+    RenderStats getLastStats() const;
+
+    /**
+     * @brief Turn the camera by mouse movement newer than the snapshot.
+     * @param look Read just before V is uploaded; nullptr to use V as is.
+     */
+    void setMouseLook( const MouseLook * look );
+
+private:
+    static const int SNAPSHOT_COUNT = 3;
+
+    Renderer( const Renderer & );
+    Renderer & operator=( const Renderer & );
+
+    /** @brief Draw every snapshot handed over until told to stop. */
+    void renderLoop();
+
+    /** @brief Draw one frame and show it. */
+    void draw( RenderSnapshot & frame );
+
+    /** @brief Draw the snapshot's models with the scene shader. */
+    void drawScene( RenderSnapshot & frame, RenderStats & stats );
+
+    /** @brief Count what the GUI renderer does with a frame's lists. */
+    static void countGui( const ImDrawData * data, RenderStats & stats );
+
+    /** @brief Draws the GUI; taken from ImGui so ImGui::Render() won't. */
+    void (*m_drawGui)( ImDrawData * data );
+
+    SDL_Window * m_window;
+    SDL_GLContext m_context;
+    Shader * m_shader;
+    PostProcess * m_postprocess;
+    FramePacer m_pacer;
+    GpuTimer m_gpuTimer;
+    const MouseLook * m_look;
+    /** @brief Size the post process targets were made for. */
+    SDL_Point m_dim;
+
+    RenderSnapshot m_snapshots[SNAPSHOT_COUNT];
+    /** @brief Snapshot the simulation is filling. */
+    int m_writing;
+    /** @brief Snapshot waiting to be drawn, or -1. */
+    int m_ready;
+    /** @brief Snapshot being drawn, or -1. */
+    int m_drawing;
+
+    bool m_threaded;
+    bool m_quit;
+    std::thread m_thread;
+    /** @brief Guards the three indices above and m_quit. */
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    /** @brief Keeps the GUI renderer from reading ImGui's IO mid-update. */
+    std::mutex m_guiMutex;
+
+    mutable std::mutex m_statsMutex;
+    RenderStats m_stats;
+};
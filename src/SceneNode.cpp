@@ -23,7 +23,9 @@ SceneNode::SceneNode(const std::string& name)
     trans(mat4()),
     invtrans(mat4()),
     m_nodeId(nodeInstanceCount++),
-    m_useBB(false)
+    m_useBB(false),
+    m_layer(LAYER_NONE),
+    m_collisionMask(LAYER_NONE)
 {
 
 }
@@ -33,7 +35,9 @@ SceneNode::SceneNode(const std::string& name)
 SceneNode::SceneNode(const SceneNode & other)
     : m_name(other.m_name),
       trans(other.trans),
-      invtrans(other.invtrans)
+      invtrans(other.invtrans),
+      m_layer(other.m_layer),
+      m_collisionMask(other.m_collisionMask)
 {
     for(SceneNode * child : other.children) {
         this->children.push_front(new SceneNode(*child));
@@ -121,12 +125,13 @@ void SceneNode::translate(const glm::vec3& amount) {
 }
 
 void
-SceneNode::draw( glm::mat4 accum )
+SceneNode::draw( glm::mat4 accum,
+                 RenderSnapshot & out )
 {
     // we don't have a representation ourselves, we just draw children
     accum = trans * accum;
     for(SceneNode * child : children) {
-        child->draw( accum );
+        child->draw( accum, out );
     }
 }
 
@@ -147,45 +152,36 @@ const {
     out_max = m_bbMax;
 }
 
-SceneNode *
-SceneNode::isCollidingWith( SceneNode & other )
-{
-    // check for collision with self
-    if ( m_useBB ) {
-        //std::cout << m_name << " is candidate for collision detection!" << std::endl;
-
-        glm::vec3 otherMax;
-        glm::vec3 otherMin;
-        other.getBoundingBox( otherMin, otherMax );
-        /*printf( "OTHER MAX: [%f %f %f]\n", otherMax.x, otherMax.y, otherMax.z );
-        printf( "OTHER MIN: [%f %f %f]\n", otherMin.x, otherMin.y, otherMin.z );
-
-        printf( "MY MAX: [%f %f %f]\n", m_bbMax.x, m_bbMax.y, m_bbMax.z );
-        printf( "MY MIN: [%f %f %f]\n", m_bbMin.x, m_bbMin.y, m_bbMin.z );*/
-
-        if( m_bbMin.x < otherMax.x && m_bbMin.y < otherMax.y && m_bbMin.z < otherMax.z &&
-            otherMin.x < m_bbMax.x && otherMin.y < m_bbMax.y && otherMin.z < m_bbMax.z )
-        {
-            return this;
-        }
-    }
+glm::vec3
+SceneNode::getLocation()
+const {
+    return glm::vec3( trans * glm::vec4( 0.f, 0.f, 0.f, 1.f ) );
+}
 
-    // otherwise check for collision with at least 1 child
-    SceneNode * foundCollision(nullptr);
-    for ( SceneNode * child : children ) {
-        if ( child->isCollidingWith( other ) ) {
-            foundCollision = child;
-            break;
-        }
-    }
+unsigned
+SceneNode::getCollisionLayer()
+const {
+    return m_layer;
+}
 
-    return foundCollision;
+unsigned
+SceneNode::getCollisionMask()
+const {
+    return m_collisionMask;
 }
 
-glm::vec3
-SceneNode::getLocation()
+void
+SceneNode::setCollisionLayer( unsigned layer,
+                              unsigned mask )
+{
+    m_layer = layer;
+    m_collisionMask = mask;
+}
+
+bool
+SceneNode::isSolid()
 const {
-    return glm::vec3( trans * glm::vec4( 0.f, 0.f, 0.f, 1.f ) );
+    return m_useBB;
 }
 
 void
@@ -6,6 +6,25 @@
 #include <string>
 #include <iostream>
 
+// forward decls
+struct RenderSnapshot;
+
+/**
+ * @brief Collision layer bits. A node is on at most one layer and has a mask
+ *        of the layers it can run into.
+ */
+enum CollisionLayer {
+    LAYER_NONE   = 0,
+    LAYER_STATIC = 1 << 0,
+    LAYER_ENEMY  = 1 << 1,
+    LAYER_CAKE   = 1 << 2,
+    LAYER_PLAYER = 1 << 3,
+    LAYER_BULLET = 1 << 4
+};
+
+/** @brief Number of bits used by CollisionLayer; LAYER_X == 1 << index. */
+const int COLLISION_LAYER_COUNT = 5;
+
 /**
  * @brief Base class for all nodes in the scene heirarchy.
  * @details Can be instantiated but doesn't have any physical properties, like
@@ -72,10 +91,11 @@ public:
     void translate(const glm::vec3& amount);
 
     /**
-     * @brief Render this node to the screen
+     * @brief Add this node and its children to a frame
      * @param accum The accumulation matrix from parents
+     * @param out The frame to add to.
      */
-    virtual void draw( glm::mat4 accum );
+    virtual void draw( glm::mat4 accum, RenderSnapshot & out );
 
     /**
      * @brief Perform any updates required at the node.
@@ -89,13 +109,24 @@ public:
      */
     void getBoundingBox( glm::vec3 & out_min, glm::vec3 & out_max ) const;
 
+    /** @brief Get the CollisionLayer bit this node is on, or LAYER_NONE. */
+    unsigned getCollisionLayer() const;
+
+    /** @brief Get the layers this node can collide with. */
+    unsigned getCollisionMask() const;
+
+    /**
+     * @brief Put this node on a collision layer.
+     * @param layer One CollisionLayer bit, or LAYER_NONE.
+     * @param mask The layers this node can collide with.
+     */
+    void setCollisionLayer( unsigned layer, unsigned mask );
+
     /**
-     * @brief Determine if the node is colliding with another node in the scene.
-     * @param other The node to test collision with.
-     * @return The node that is colliding, false otherwise.
-     * @remark Recursive, checks self and children
+     * @brief Get whether this node participates in collision detection.
+     * @return true if solid, false otherwise.
      */
-    SceneNode * isCollidingWith( SceneNode & other );
+    bool isSolid() const;
 
     /**
      * @brief Get location relative to parent.
@@ -118,6 +149,10 @@ protected:
     glm::vec3 m_bbMax;
     /** @brief Whether to use the bounding box */
     bool m_useBB;
+    /** @brief The CollisionLayer this node is on */
+    unsigned m_layer;
+    /** @brief The layers this node can collide with */
+    unsigned m_collisionMask;
 
     /**
      * @brief Sets whether this node should participate in collision detection.
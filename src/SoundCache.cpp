@@ -3,6 +3,7 @@
 #include <iostream>
 #include <SDL.h>
 #include "Exception.hpp"
+#include "Profiler.hpp"
 
 SoundCache * SoundCache::instance = nullptr;
 
@@ -21,6 +22,7 @@ SoundCache::get( const std::string & filename )
     // lazy load if it doesn't exist
     auto it = m_cache.find( filename );
     if ( it == m_cache.end() ) {
+        PROFILE_SCOPE( "Load sound" );
         std::cout << "Loading sound " << filename << std::endl;
 
         Mix_Chunk * sound = Mix_LoadWAV( filename.c_str() );
@@ -0,0 +1,116 @@
+#include "SpatialHash.hpp"
+
+#include <cmath>
+
+// Most grid cells a query reads slot by slot; 4x4 leaves room for a radius
+// a little over the cell size
+static const int MAX_QUERY_CELLS = 16;
+
+SpatialHash::SpatialHash():
+    m_cellSize( 1.f ),
+    m_tableSize( 1 ),
+    m_bucketStart( 2, 0 ),
+    m_entries(),
+    m_x(),
+    m_z()
+{
+    // nothing else to do
+}
+
+int
+SpatialHash::bucketOf( int cellX,
+                       int cellZ )
+const {
+    // Large primes to scatter neighbouring cells across the table
+    unsigned h = (unsigned)cellX * 73856093u ^ (unsigned)cellZ * 19349663u;
+    return h & ( m_tableSize - 1 );
+}
+
+void
+SpatialHash::build( const std::vector<glm::vec3> & positions,
+                    float cellSize )
+{
+    m_cellSize = cellSize;
+
+    int count = positions.size();
+    m_tableSize = 1;
+    while ( m_tableSize < 2 * count ) m_tableSize <<= 1;
+
+    // Counting sort by slot: count, prefix sum, then scatter
+    std::vector<int> slots( count );
+    m_bucketStart.assign( m_tableSize + 1, 0 );
+    for ( int i = 0; i < count; i++ ) {
+        int cx = (int)std::floor( positions[i].x / cellSize );
+        int cz = (int)std::floor( positions[i].z / cellSize );
+        slots[i] = bucketOf( cx, cz );
+        m_bucketStart[slots[i] + 1]++;
+    }
+    for ( int b = 0; b < m_tableSize; b++ ) {
+        m_bucketStart[b + 1] += m_bucketStart[b];
+    }
+
+    std::vector<int> fill( m_bucketStart.begin(), m_bucketStart.end() - 1 );
+    m_entries.resize( count );
+    m_x.resize( count );
+    m_z.resize( count );
+    for ( int i = 0; i < count; i++ ) {
+        int at = fill[slots[i]]++;
+        m_entries[at] = i;
+        m_x[at] = positions[i].x;
+        m_z[at] = positions[i].z;
+    }
+}
+
+void
+SpatialHash::findNeighbours( const glm::vec3 & position,
+                             float radius,
+                             std::vector<int> & out )
+const {
+    if ( m_entries.empty() ) return;
+
+    int minX = (int)std::floor( ( position.x - radius ) / m_cellSize );
+    int maxX = (int)std::floor( ( position.x + radius ) / m_cellSize );
+    int minZ = (int)std::floor( ( position.z - radius ) / m_cellSize );
+    int maxZ = (int)std::floor( ( position.z + radius ) / m_cellSize );
+    float radius2 = radius * radius;
+
+    // Radius no bigger than a cell covers at most 3x3 cells. Anything that
+    // covers more is rare enough to just test every point.
+    if ( ( maxX - minX + 1 ) * ( maxZ - minZ + 1 ) > MAX_QUERY_CELLS ) {
+        for ( int at = 0; at < (int)m_entries.size(); at++ ) {
+            float dx = m_x[at] - position.x;
+            float dz = m_z[at] - position.z;
+            if ( dx * dx + dz * dz <= radius2 ) out.push_back( m_entries[at] );
+        }
+        return;
+    }
+
+    // Different cells can share a slot; only read each slot once
+    int visited[MAX_QUERY_CELLS];
+    int visitedCount = 0;
+    for ( int cz = minZ; cz <= maxZ; cz++ ) {
+        for ( int cx = minX; cx <= maxX; cx++ ) {
+            int b = bucketOf( cx, cz );
+            bool seen = false;
+            for ( int v = 0; v < visitedCount; v++ ) {
+                if ( visited[v] == b ) seen = true;
+            }
+            if ( seen ) continue;
+            visited[visitedCount++] = b;
+
+            // The distance test also throws out points from other cells
+            // that landed in this slot
+            for ( int at = m_bucketStart[b]; at < m_bucketStart[b + 1]; at++ ) {
+                float dx = m_x[at] - position.x;
+                float dz = m_z[at] - position.z;
+                if ( dx * dx + dz * dz <= radius2 ) out.push_back( m_entries[at] );
+            }
+        }
+    }
+}
+
+int
+SpatialHash::size()
+const {
+    return m_entries.size();
+}
@@ -0,0 +1,63 @@
+/**
+ * @file SpatialHash.hpp
+ * @brief Interface for SpatialHash
+ * @author Michael Hitchens
+ */
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+/**
+ * @brief Buckets points on the XZ plane by grid cell for fast neighbour
+ *        lookups.
+ * @details Meant to be rebuilt from scratch every timestep. Building is a
+ *          counting sort, so points in the same bucket sit next to each other
+ *          in memory and a lookup only reads a few short runs.
+ * @remark The grid is unbounded; cells are hashed into a table about twice
+ *         the size of the point count.
+ */
+class SpatialHash {
+public:
+    SpatialHash();
+
+    /**
+     * @brief Put a set of points in the hash, replacing the old ones.
+     * @param positions The points; y is ignored.
+     * @param cellSize Size of a grid cell. Lookups are fastest when this
+     *                 matches the search radius.
+     */
+    void build( const std::vector<glm::vec3> & positions, float cellSize );
+
+    /**
+     * @brief Find the points within a distance of a position.
+     * @param position Where to look; y is ignored.
+     * @param radius How far to look, in the XZ plane.
+     * @param out Where to append the indices of the points found, as given
+     *            to build(). Includes a point at the position itself.
+     * @remark Doesn't allocate beyond growing out. Best with a radius no
+     *         bigger than the cell size; much bigger and every point is
+     *         tested.
+     */
+    void findNeighbours( const glm::vec3 & position, float radius, std::vector<int> & out ) const;
+
+    /** @brief Get the number of points in the hash. */
+    int size() const;
+
+private:
+    /** @brief Table slot for a grid cell. */
+    int bucketOf( int cellX, int cellZ ) const;
+
+    float m_cellSize;
+    /** @brief Number of table slots; a power of two. */
+    int m_tableSize;
+    /** @brief Points in slot i are m_entries[m_bucketStart[i], m_bucketStart[i+1]). */
+    std::vector<int> m_bucketStart;
+    /** @brief Point indices sorted by slot. */
+    std::vector<int> m_entries;
+    /** @brief Point X coordinates in m_entries order. */
+    std::vector<float> m_x;
+    /** @brief Point Z coordinates in m_entries order. */
+    std::vector<float> m_z;
+};
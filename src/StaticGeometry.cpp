@@ -0,0 +1,83 @@
+#include "StaticGeometry.hpp"
+
+#include "Model.hpp"
+#include "RenderSnapshot.hpp"
+
+#include <glm/gtx/transform.hpp>
+
+#include <type_traits>
+
+// The level arena only skips destructors for types that don't need one
+static_assert( std::is_trivially_destructible<StaticGeometry>::value, "StaticGeometry must be trivially destructible" );
+
+StaticGeometry::StaticGeometry( Model * prim,
+                                Material * mat,
+                                unsigned layer ):
+    m_model( prim ),
+    m_material( mat ),
+    m_trans(),
+    m_box(),
+    m_layer( layer ),
+    m_animation()
+{
+    prim->getBoundingBox( m_box.min, m_box.max );
+    startAnimation( m_animation, m_model );
+}
+
+void
+StaticGeometry::scale( const glm::vec3 & amount )
+{
+    m_trans = glm::scale( amount ) * m_trans;
+
+    // Same as SceneNode; the box is scaled about the origin
+    m_box.min *= amount;
+    m_box.max *= amount;
+}
+
+void
+StaticGeometry::translate( const glm::vec3 & amount )
+{
+    m_trans = glm::translate( amount ) * m_trans;
+    m_box = m_box.translated( amount );
+}
+
+glm::vec3
+StaticGeometry::getLocation()
+const {
+    return glm::vec3( m_trans * glm::vec4( 0.f, 0.f, 0.f, 1.f ) );
+}
+
+const AABB &
+StaticGeometry::getBoundingBox()
+const {
+    return m_box;
+}
+
+unsigned
+StaticGeometry::getCollisionLayer()
+const {
+    return m_layer;
+}
+
+bool
+StaticGeometry::isAnimated()
+const {
+    return m_model->isAnimated();
+}
+
+void
+StaticGeometry::update()
+{
+    stepAnimation( m_animation, m_model );
+}
+
+void
+StaticGeometry::getDrawItem( float interpolation,
+                             DrawItem & out )
+const {
+    out.model = m_model;
+    sampleAnimation( m_animation, m_model, interpolation, out.keyframe, out.blend );
+    out.material = m_material;
+    out.M = m_trans;
+    out.alpha = 1.f;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file StaticGeometry.hpp
+ * @brief Interface for StaticGeometry
+ * @author Michael Hitchens
+ */
+
+#pragma once
+
+#include "AABB.hpp"
+#include "AnimationState.hpp"
+#include <glm/glm.hpp>
+
+// forward decls
+class Material;
+class Model;
+struct DrawItem;
+
+/**
+ * @brief A model placed in the level once, while the level is built.
+ * @details Level scenery never moves and has no children, so it isn't part
+ *          of a scene graph. It owns nothing and is trivially destructible;
+ *          a whole level of it goes away with the level arena without any
+ *          of it being visited.
+ * @remark Only place it before the level builds its collision.
+ */
+class StaticGeometry {
+public:
+    /**
+     * @brief Create scenery from a model and some texture.
+     * @param prim The model to use.
+     * @param mat The material to draw the model.
+     * @param layer The CollisionLayer it's on, or LAYER_NONE.
+     */
+    StaticGeometry( Model * prim, Material * mat, unsigned layer );
+
+    //-- Transformations, same as SceneNode:
+    void scale( const glm::vec3 & amount );
+    void translate( const glm::vec3 & amount );
+
+    /** @brief Get where the model's origin ended up, in world space. */
+    glm::vec3 getLocation() const;
+
+    /** @brief Get the world space bounding box. */
+    const AABB & getBoundingBox() const;
+
+    unsigned getCollisionLayer() const;
+
+    /** @brief Get whether our model has keyframes to play. */
+    bool isAnimated() const;
+
+    /** @brief Play one update of our animation. */
+    void update();
+
+    /**
+     * @brief Describe how to draw this.
+     * @param interpolation How far between the last two updates to draw,
+     *                      in [0, 1].
+     * @param out The item to fill in.
+     * @remark Many can be described at once on different threads.
+     */
+    void getDrawItem( float interpolation, DrawItem & out ) const;
+
+private:
+    /** @brief Actual vertices that make up the geometry. */
+    Model * m_model;
+    /** @brief The visual properties of the model. */
+    Material * m_material;
+    /** @brief Model to world transform. */
+    glm::mat4 m_trans;
+    /** @brief World space bounding box. */
+    AABB m_box;
+    /** @brief The CollisionLayer we're on. */
+    unsigned m_layer;
+    /** @brief Where our model is in its keyframes. */
+    AnimationState m_animation;
+};
@@ -0,0 +1,139 @@
+#include "Systems.hpp"
+
+#include "JobSystem.hpp"
+#include "DrawPackets.hpp"
+
+#include <glm/gtx/transform.hpp>
+
+#include <cmath>
+#include <vector>
+
+#define VEC3_ENTRYWISE(a,b) glm::vec3(a.x*b.x, a.y*b.y, a.z*b.z)
+
+// Components per job for the systems that run on many threads
+static const int SYSTEM_GRAIN = 512;
+
+void
+emitParticles( World & world )
+{
+    // Particles are only added to other arrays, so the emitters stay put
+    for ( int i = 0; i < world.emitters.size(); i++ ) {
+        Lifetime * emitterLife = world.lifetimes.find( world.emitters.getEntity( i ) );
+        if ( emitterLife && emitterLife->remaining <= 0 ) continue;
+
+        const ParticleSystemConfig & conf = world.emitters[i].config;
+
+        double nparts = conf.number[PSYS_MEAN] + ParticleSystem::random() * conf.number[PSYS_VAR];
+        int rounded_nparts = round(nparts);
+
+        for ( int n = 0; n < rounded_nparts; n++ ) {
+            int life = conf.life[PSYS_MEAN] + ParticleSystem::random() * conf.life[PSYS_VAR];
+            glm::vec3 velocity = conf.velocity[PSYS_MEAN] + VEC3_ENTRYWISE( ParticleSystem::randomVector(), conf.velocity[PSYS_VAR] );
+            glm::vec3 acceleration = conf.acceleration[PSYS_MEAN] + VEC3_ENTRYWISE( ParticleSystem::randomVector(), conf.acceleration[PSYS_VAR] );
+            glm::vec3 position = conf.position[PSYS_MEAN] + VEC3_ENTRYWISE( ParticleSystem::randomVector(), conf.position[PSYS_VAR] );
+            glm::vec3 scale = conf.scale[PSYS_MEAN] + VEC3_ENTRYWISE( ParticleSystem::randomVector(), conf.scale[PSYS_VAR] );
+
+            // Particles aren't solid; colliding with effects would be annoying
+            Entity p = world.create();
+            Transform transform = { position, scale, position };
+            Velocity motion = { velocity, acceleration };
+            Lifetime lifetime = { life, life };
+            RenderMesh mesh = { conf.model, conf.material, 1.f, true };
+            world.transforms.add( p, transform );
+            world.velocities.add( p, motion );
+            world.lifetimes.add( p, lifetime );
+            world.meshes.add( p, mesh );
+        }
+    }
+}
+
+void
+integrateMotion( World & world )
+{
+    // Every entity has at most one of each, so jobs never share components
+    JobSystem::getInstance()->parallelFor( world.velocities.size(), SYSTEM_GRAIN, [&]( int begin, int end ) {
+        for ( int i = begin; i < end; i++ ) {
+            Velocity & v = world.velocities[i];
+            Transform * t = world.transforms.find( world.velocities.getEntity( i ) );
+            if ( t ) {
+                t->previous = t->position;
+                t->position += v.linear;
+            }
+            v.linear += v.acceleration;
+        }
+    });
+}
+
+void
+animateMeshes( World & world )
+{
+    JobSystem::getInstance()->parallelFor( world.animations.size(), SYSTEM_GRAIN, [&]( int begin, int end ) {
+        for ( int i = begin; i < end; i++ ) {
+            const RenderMesh * mesh = world.meshes.find( world.animations.getEntity( i ) );
+            if ( mesh ) stepAnimation( world.animations[i], mesh->model );
+        }
+    });
+}
+
+void
+ageLifetimes( World & world )
+{
+    JobSystem::getInstance()->parallelFor( world.lifetimes.size(), SYSTEM_GRAIN, [&]( int begin, int end ) {
+        for ( int i = begin; i < end; i++ ) {
+            Lifetime & life = world.lifetimes[i];
+
+            // fade from what's left before this update, so new things start
+            // opaque
+            RenderMesh * mesh = world.meshes.find( world.lifetimes.getEntity( i ) );
+            if ( mesh && mesh->fadeOut && life.start > 0 ) {
+                mesh->alpha = life.remaining / (float)life.start;
+            }
+            life.remaining--;
+        }
+    });
+}
+
+void
+removeDeadEntities( World & world )
+{
+    std::vector<Entity> toRemove;
+    for ( int i = 0; i < world.lifetimes.size(); i++ ) {
+        if ( world.lifetimes[i].remaining <= 0 ) toRemove.push_back( world.lifetimes.getEntity( i ) );
+    }
+    for ( int i = 0; i < world.healths.size(); i++ ) {
+        if ( world.healths[i].points <= 0 ) toRemove.push_back( world.healths.getEntity( i ) );
+    }
+
+    // destroy ignores entities already gone, so doubles are fine
+    for ( Entity e : toRemove ) {
+        world.destroy( e );
+    }
+}
+
+void
+drawMeshes( World & world,
+            float interpolation,
+            DrawPackets & out )
+{
+    JobSystem::getInstance()->parallelFor( world.meshes.size(), SYSTEM_GRAIN, [&]( int begin, int end ) {
+        for ( int i = begin; i < end; i++ ) {
+            const RenderMesh & mesh = world.meshes[i];
+            Entity e = world.meshes.getEntity( i );
+            const Transform * t = world.transforms.find( e );
+            if ( !t ) continue;
+
+            // meshes without an animation show their first keyframe
+            DrawItem item;
+            item.model = mesh.model;
+            item.keyframe = 0;
+            item.blend = 0.f;
+            const AnimationState * anim = world.animations.find( e );
+            if ( anim ) sampleAnimation( *anim, mesh.model, interpolation, item.keyframe, item.blend );
+            item.material = mesh.material;
+            glm::vec3 position = glm::mix( t->previous, t->position, interpolation );
+            item.M = glm::translate( position ) * glm::scale( t->scale );
+            item.alpha = mesh.alpha;
+            out.add( item );
+        }
+    });
+}
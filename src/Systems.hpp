@@ -0,0 +1,46 @@
+/**
+ * @file Systems.hpp
+ * @brief Updates that run over the components in a World.
+ * @author Michael Hitchens
+ * @remark Each system walks one dense component array from front to back and
+ *         looks up the few other components it needs by entity. Systems that
+ *         don't add or remove anything split the walk over the JobSystem.
+ */
+
+#pragma once
+
+#include "World.hpp"
+
+// forward decls
+class DrawPackets;
+
+/**
+ * @brief Spawn this update's particles for every emitter still alive.
+ * @details Mean + random * variance for every property, as in "Particle
+ *          Systems -- A Technique for Modelling a Class of Fuzzy Objects" by
+ *          Reeves.
+ */
+void emitParticles( World & world );
+
+/**
+ * @brief Move everything with a velocity, then accelerate it.
+ * @remark Where it was before moving is kept in Transform::previous.
+ */
+void integrateMotion( World & world );
+
+/** @brief Play one update of every animation on its mesh's model. */
+void animateMeshes( World & world );
+
+/** @brief Count down every lifetime and fade out meshes that ask for it. */
+void ageLifetimes( World & world );
+
+/** @brief Destroy entities whose lifetime or health ran out. */
+void removeDeadEntities( World & world );
+
+/**
+ * @brief Add every mesh to a frame.
+ * @param interpolation How far from the previous position to the current
+ *                      one to draw, in [0, 1].
+ * @param out The packets to add the meshes to.
+ */
+void drawMeshes( World & world, float interpolation, DrawPackets & out );
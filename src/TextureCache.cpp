@@ -3,6 +3,7 @@
 #include <cstdio>
 #include "Texture.hpp"
 #include "Material.hpp"
+#include "Profiler.hpp"
 
 TextureCache * TextureCache::instance = nullptr;
 
@@ -25,6 +26,7 @@ TextureCache::get( const std::string & filename )
     // lazy load if it doesn't exist
     auto it = m_cache.find( filename );
     if ( it == m_cache.end() ) {
+        PROFILE_SCOPE( "Load texture" );
         printf( "Loading texture %s\n", filename.c_str() );
         m_cache[filename] = new Texture( filename.c_str() );
     }
@@ -0,0 +1,200 @@
+#include "TraceCapture.hpp"
+
+#include <utility>
+
+// Process id every event is given; there's only the one process
+static const int TRACE_PID = 1;
+
+TraceCapture::TraceCapture():
+    m_remaining(0),
+    m_wasEnabled(false),
+    m_counters(),
+    m_filename(),
+    m_file(nullptr),
+    m_wroteEvent(false),
+    m_namedThreads(0),
+    m_mutex(),
+    m_queued(),
+    m_queue(),
+    m_writer()
+{
+    // nothing else to do
+}
+
+TraceCapture::~TraceCapture()
+{
+    if ( m_remaining > 0 ) {
+        // Finish the file with what we have so far
+        Frame frame;
+        frame.start = 0;
+        frame.last = true;
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_queue.push_back( frame );
+        }
+        m_queued.notify_one();
+    }
+    if ( m_writer.joinable() ) m_writer.join();
+}
+
+bool
+TraceCapture::start( const std::string & filename,
+                     int frames )
+{
+    if ( m_remaining > 0 || frames <= 0 ) return false;
+
+    // The last capture's writer may still be going
+    if ( m_writer.joinable() ) m_writer.join();
+
+    m_file = fopen( filename.c_str(), "w" );
+    if ( m_file == nullptr ) {
+        printf( "Couldn't open %s for a trace\n", filename.c_str() );
+        return false;
+    }
+
+    printf( "Capturing %d frames to %s\n", frames, filename.c_str() );
+    m_filename = filename;
+    m_remaining = frames;
+    m_counters.clear();
+    m_wroteEvent = false;
+    m_namedThreads = 0;
+
+    Profiler * profiler = Profiler::getInstance();
+    m_wasEnabled = profiler->isEnabled();
+    profiler->setEnabled( true );
+
+    m_writer = std::thread( &TraceCapture::writeLoop, this );
+    return true;
+}
+
+bool
+TraceCapture::isCapturing()
+const {
+    return m_remaining > 0;
+}
+
+void
+TraceCapture::addCounter( const char * track,
+                          const char * name,
+                          float value )
+{
+    if ( m_remaining <= 0 ) return;
+
+    TraceCounter counter = { track, name, value };
+    m_counters.push_back( counter );
+}
+
+void
+TraceCapture::addFrame( const Profiler & profiler )
+{
+    if ( m_remaining <= 0 ) return;
+    m_remaining--;
+
+    Frame frame;
+    frame.start = profiler.getFrameStart();
+    frame.zones = profiler.getFrameZones();
+    frame.counters.swap( m_counters );
+    frame.last = m_remaining == 0;
+    bool last = frame.last;
+
+    int threadCount = profiler.getThreadCount();
+    for ( int i = 0; i < threadCount; i++ ) {
+        frame.threadNames.push_back( profiler.getThreadName( i ) );
+    }
+
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_queue.push_back( std::move( frame ) );
+    }
+    m_queued.notify_one();
+
+    if ( last ) Profiler::getInstance()->setEnabled( m_wasEnabled );
+}
+
+void
+TraceCapture::writeLoop()
+{
+    fprintf( m_file, "{\"traceEvents\":[\n" );
+
+    while ( true ) {
+        Frame frame;
+        {
+            std::unique_lock<std::mutex> lock( m_mutex );
+            m_queued.wait( lock, [this]() { return !m_queue.empty(); } );
+            frame = std::move( m_queue.front() );
+            m_queue.pop_front();
+        }
+
+        writeFrame( frame );
+        if ( frame.last ) break;
+    }
+
+    fprintf( m_file, "\n],\"displayTimeUnit\":\"ms\"}\n" );
+    fclose( m_file );
+    m_file = nullptr;
+    printf( "Wrote trace to %s\n", m_filename.c_str() );
+}
+
+void
+TraceCapture::writeFrame( const Frame & frame )
+{
+    // Chrome wants microseconds; keep the nanoseconds as decimals
+    for ( ; m_namedThreads < frame.threadNames.size(); m_namedThreads++ ) {
+        fprintf( m_file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"",
+                 m_wroteEvent ? ",\n" : "", TRACE_PID, (int)m_namedThreads );
+        writeString( frame.threadNames[m_namedThreads] );
+        fprintf( m_file, "\"}}" );
+        m_wroteEvent = true;
+    }
+
+    if ( frame.start == 0 && frame.zones.empty() ) return;
+
+    fprintf( m_file, "%s{\"name\":\"Frame\",\"ph\":\"i\",\"s\":\"g\",\"pid\":%d,\"tid\":0,\"ts\":%.3f}",
+             m_wroteEvent ? ",\n" : "", TRACE_PID, frame.start / 1e3 );
+    m_wroteEvent = true;
+
+    for ( const ProfileZone & zone : frame.zones ) {
+        fprintf( m_file, ",\n{\"name\":\"" );
+        writeString( zone.name );
+        fprintf( m_file, "\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                 TRACE_PID, zone.thread, zone.start / 1e3, ( zone.end - zone.start ) / 1e3 );
+    }
+
+    // One event per track, holding every value of that track
+    std::vector<bool> written( frame.counters.size(), false );
+    for ( std::size_t i = 0; i < frame.counters.size(); i++ ) {
+        if ( written[i] ) continue;
+
+        const char * track = frame.counters[i].track;
+        fprintf( m_file, ",\n{\"name\":\"" );
+        writeString( track );
+        fprintf( m_file, "\",\"ph\":\"C\",\"pid\":%d,\"ts\":%.3f,\"args\":{", TRACE_PID, frame.start / 1e3 );
+
+        bool first = true;
+        for ( std::size_t j = i; j < frame.counters.size(); j++ ) {
+            if ( written[j] || std::string( frame.counters[j].track ) != track ) continue;
+            written[j] = true;
+
+            fprintf( m_file, first ? "\"" : ",\"" );
+            writeString( frame.counters[j].name );
+            fprintf( m_file, "\":%g", frame.counters[j].value );
+            first = false;
+        }
+        fprintf( m_file, "}}" );
+    }
+}
+
+void
+TraceCapture::writeString( const std::string & str )
+{
+    for ( char c : str ) {
+        if ( c == '"' || c == '\\' ) {
+            fputc( '\\', m_file );
+            fputc( c, m_file );
+        } else if ( (unsigned char)c < 0x20 ) {
+            fprintf( m_file, "\\u%04x", c );
+        } else {
+            fputc( c, m_file );
+        }
+    }
+}
@@ -0,0 +1,117 @@
+/**
+ * @file TraceCapture.hpp
+ * @brief Interface for TraceCapture
+ * @author Michael Hitchens
+ */
+
+#pragma once
+
+#include "Profiler.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief One value plotted over time in a capture.
+ * @details Counters sharing a track are drawn together as one graph.
+ */
+struct TraceCounter {
+    /** @brief String literal naming the graph. */
+    const char * track;
+    /** @brief String literal naming the line within the graph. */
+    const char * name;
+    float value;
+};
+
+/**
+ * @brief Records some frames of profiler zones and counters to a file.
+ * @details The file is Chrome Trace Event JSON, which opens in
+ *          chrome://tracing and ui.perfetto.dev. Each frame is copied on the
+ *          main thread and turned into text and written by a thread of its
+ *          own, so the frames being measured only pay for the copy.
+ * @remark Turns the profiler on while capturing and back to how it was
+ *         after. Main thread only, apart from the writer it starts.
+ */
+class TraceCapture {
+public:
+    TraceCapture();
+
+    /** @brief Waits for the file to finish being written. */
+    ~TraceCapture();
+
+    /**
+     * @brief Start recording the next frames.
+     * @param filename Where to write; replaced if it exists.
+     * @param frames How many frames to record.
+     * @return False if already capturing or the file can't be opened.
+     */
+    bool start( const std::string & filename, int frames );
+
+    /** @brief Get whether frames are still being recorded. */
+    bool isCapturing() const;
+
+    /**
+     * @brief Add a value to the frame being recorded.
+     * @remark Ignored when not capturing.
+     */
+    void addCounter( const char * track, const char * name, float value );
+
+    /**
+     * @brief Record the frame the profiler just closed, with the counters
+     *        added since the last call.
+     * @remark Call after Profiler::beginFrame(). The last frame finishes
+     *         the capture.
+     */
+    void addFrame( const Profiler & profiler );
+
+private:
+    /** @brief Everything recorded in one frame. */
+    struct Frame {
+        std::uint64_t start;
+        std::vector<ProfileZone> zones;
+        std::vector<TraceCounter> counters;
+        /** @brief Names of every thread so far, by index. */
+        std::vector<std::string> threadNames;
+        /** @brief Whether this is the last frame of the capture. */
+        bool last;
+    };
+
+    TraceCapture( const TraceCapture & );
+    TraceCapture & operator=( const TraceCapture & );
+
+    /** @brief Write frames until the last one; runs on m_writer. */
+    void writeLoop();
+
+    /** @brief Write the events of one frame to m_file. */
+    void writeFrame( const Frame & frame );
+
+    /** @brief Write a string with JSON escapes, without quotes. */
+    void writeString( const std::string & str );
+
+    /** @brief Frames left to record; 0 when not capturing. */
+    int m_remaining;
+    /** @brief Whether the profiler was on before the capture turned it on. */
+    bool m_wasEnabled;
+    /** @brief Counters for the frame being recorded. */
+    std::vector<TraceCounter> m_counters;
+
+    std::string m_filename;
+    /** @brief Owned by the writer while it runs. */
+    FILE * m_file;
+    /** @brief Whether the writer has written an event yet; writer only. */
+    bool m_wroteEvent;
+    /** @brief Thread names written so far; writer only. */
+    std::size_t m_namedThreads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_queued;
+    /** @brief Frames waiting to be written, oldest first. */
+    std::deque<Frame> m_queue;
+    std::thread m_writer;
+};
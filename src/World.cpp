@@ -0,0 +1,106 @@
+#include "World.hpp"
+
+#include "Exception.hpp"
+
+World::World():
+    transforms(),
+    velocities(),
+    lifetimes(),
+    healths(),
+    meshes(),
+    colliders(),
+    emitters(),
+    animations(),
+    enemies(),
+    m_generations(),
+    m_alive(),
+    m_freeSlots(),
+    m_entityCount(0)
+{
+    // nothing else to do
+}
+
+Entity
+World::create()
+{
+    unsigned slot;
+    if ( !m_freeSlots.empty() ) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    } else {
+        slot = m_generations.size();
+        if ( slot > ENTITY_INDEX_MASK ) {
+            throw Exception( "Too many entities!" );
+        }
+        m_generations.push_back( 0 );
+        m_alive.push_back( false );
+    }
+
+    m_alive[slot] = true;
+    m_entityCount++;
+
+    // Never hand out NULL_ENTITY
+    Entity e = ( m_generations[slot] << ENTITY_INDEX_BITS ) | slot;
+    if ( e == NULL_ENTITY ) {
+        m_generations[slot]++;
+        e = ( m_generations[slot] << ENTITY_INDEX_BITS ) | slot;
+    }
+    return e;
+}
+
+void
+World::destroy( Entity e )
+{
+    if ( !isAlive( e ) ) return;
+
+    transforms.remove( e );
+    velocities.remove( e );
+    lifetimes.remove( e );
+    healths.remove( e );
+    meshes.remove( e );
+    colliders.remove( e );
+    emitters.remove( e );
+    animations.remove( e );
+    enemies.remove( e );
+
+    unsigned slot = e & ENTITY_INDEX_MASK;
+    m_alive[slot] = false;
+    m_generations[slot]++;
+    m_freeSlots.push_back( slot );
+    m_entityCount--;
+}
+
+bool
+World::isAlive( Entity e )
+const {
+    unsigned slot = e & ENTITY_INDEX_MASK;
+    if ( e == NULL_ENTITY || slot >= m_generations.size() ) return false;
+
+    unsigned generation = m_generations[slot] & ( 0xFFFFFFFFu >> ENTITY_INDEX_BITS );
+    return m_alive[slot] && ( e >> ENTITY_INDEX_BITS ) == generation;
+}
+
+void
+World::clear()
+{
+    transforms.clear();
+    velocities.clear();
+    lifetimes.clear();
+    healths.clear();
+    meshes.clear();
+    colliders.clear();
+    emitters.clear();
+    animations.clear();
+    enemies.clear();
+
+    m_generations.clear();
+    m_alive.clear();
+    m_freeSlots.clear();
+    m_entityCount = 0;
+}
+
+int
+World::getEntityCount()
+const {
+    return m_entityCount;
+}
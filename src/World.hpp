@@ -0,0 +1,184 @@
+/**
+ * @file World.hpp
+ * @brief Interface for World
+ * @author Michael Hitchens
+ */
+
+#pragma once
+
+#include "Components.hpp"
+#include "Entity.hpp"
+
+#include <vector>
+
+/**
+ * @brief One kind of component for every entity that has it, packed densely.
+ * @details Components sit next to each other in a plain array so systems can
+ *          walk them in order. A sparse table maps entity slots to array
+ *          positions. Removing swaps the last component into the hole, so
+ *          order is not kept.
+ * @remark Adding or removing can move components; don't hold pointers across
+ *         either.
+ */
+template <typename T>
+class ComponentArray {
+public:
+    ComponentArray():
+        m_dense(),
+        m_entities(),
+        m_sparse()
+    {
+        // nothing else to do
+    }
+
+    /**
+     * @brief Give an entity this component.
+     * @return The stored component; replaced if the entity already had one.
+     */
+    T & add( Entity e, const T & value )
+    {
+        unsigned slot = e & ENTITY_INDEX_MASK;
+        if ( slot >= m_sparse.size() ) m_sparse.resize( slot + 1, -1 );
+
+        int i = m_sparse[slot];
+        if ( i >= 0 && m_entities[i] == e ) {
+            m_dense[i] = value;
+            return m_dense[i];
+        }
+
+        m_sparse[slot] = m_dense.size();
+        m_dense.push_back( value );
+        m_entities.push_back( e );
+        return m_dense.back();
+    }
+
+    /** @brief Take this component away from an entity, if it has one. */
+    void remove( Entity e )
+    {
+        int i = indexOf( e );
+        if ( i < 0 ) return;
+
+        int last = m_dense.size() - 1;
+        if ( i != last ) {
+            m_dense[i] = m_dense[last];
+            m_entities[i] = m_entities[last];
+            m_sparse[m_entities[i] & ENTITY_INDEX_MASK] = i;
+        }
+        m_dense.pop_back();
+        m_entities.pop_back();
+        m_sparse[e & ENTITY_INDEX_MASK] = -1;
+    }
+
+    /** @brief Get the component of an entity, or nullptr if it has none. */
+    T * find( Entity e )
+    {
+        int i = indexOf( e );
+        return i < 0 ? nullptr : &m_dense[i];
+    }
+
+    const T * find( Entity e ) const
+    {
+        int i = indexOf( e );
+        return i < 0 ? nullptr : &m_dense[i];
+    }
+
+    bool has( Entity e ) const
+    {
+        return indexOf( e ) >= 0;
+    }
+
+    /** @brief Get the number of components. */
+    int size() const
+    {
+        return m_dense.size();
+    }
+
+    /** @brief Get a component by its position in the dense array. */
+    T & operator[]( int i )
+    {
+        return m_dense[i];
+    }
+
+    const T & operator[]( int i ) const
+    {
+        return m_dense[i];
+    }
+
+    /** @brief Get the entity owning the component at a dense position. */
+    Entity getEntity( int i ) const
+    {
+        return m_entities[i];
+    }
+
+    void clear()
+    {
+        m_dense.clear();
+        m_entities.clear();
+        m_sparse.clear();
+    }
+
+private:
+    /** @brief Dense position of an entity's component, or -1. */
+    int indexOf( Entity e ) const
+    {
+        unsigned slot = e & ENTITY_INDEX_MASK;
+        if ( slot >= m_sparse.size() ) return -1;
+        int i = m_sparse[slot];
+        return ( i >= 0 && m_entities[i] == e ) ? i : -1;
+    }
+
+    /** @brief The components, in no particular order. */
+    std::vector<T> m_dense;
+    /** @brief m_entities[i] owns m_dense[i]. */
+    std::vector<Entity> m_entities;
+    /** @brief Dense position for each entity slot; -1 if none. */
+    std::vector<int> m_sparse;
+};
+
+/**
+ * @brief Holds gameplay objects as entities made of components.
+ * @details An entity is only a handle; what it is comes from which component
+ *          arrays hold something for it. Systems (see Systems.hpp) walk the
+ *          arrays they care about from front to back.
+ * @remark Entities destroyed while a system is walking an array would move
+ *         other components around; systems mark things dead and
+ *         removeDeadEntities() cleans up afterwards.
+ */
+class World {
+public:
+    World();
+
+    /** @brief Make a new entity with no components. */
+    Entity create();
+
+    /** @brief Remove an entity and all of its components. */
+    void destroy( Entity e );
+
+    /** @brief Get whether a handle still refers to a live entity. */
+    bool isAlive( Entity e ) const;
+
+    /** @brief Remove every entity. */
+    void clear();
+
+    /** @brief Get the number of live entities. */
+    int getEntityCount() const;
+
+    ComponentArray<Transform> transforms;
+    ComponentArray<Velocity> velocities;
+    ComponentArray<Lifetime> lifetimes;
+    ComponentArray<Health> healths;
+    ComponentArray<RenderMesh> meshes;
+    ComponentArray<Collider> colliders;
+    ComponentArray<Emitter> emitters;
+    ComponentArray<AnimationState> animations;
+    ComponentArray<EnemyState> enemies;
+
+private:
+    /** @brief Reuse count of each slot; the high bits of an Entity. */
+    std::vector<unsigned> m_generations;
+    /** @brief Whether each slot holds a live entity. */
+    std::vector<bool> m_alive;
+    /** @brief Slots free to reuse. */
+    std::vector<unsigned> m_freeSlots;
+    int m_entityCount;
+};
@@ -8,9 +8,12 @@
 #include <cstdio>
 #include <ctime>
 #include <cstdlib>
+#include <cstring>
 
+#include <algorithm>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include <glm/glm.hpp>
 #include <glm/gtx/transform.hpp>
@@ -26,21 +29,26 @@
 #include "Texture.hpp"
 #include "Player.hpp"
 #include "Model.hpp"
-#include "GeometryNode.hpp"
 #include "TextureCache.hpp"
 #include "ModelCache.hpp"
 #include "SoundCache.hpp"
 #include "Material.hpp"
 #include "Bullet.hpp"
 #include "ParticleSystem.hpp"
+#include "JobSystem.hpp"
 #include "Enemy.hpp"
 #include "PostProcess.hpp"
 #include "Level.hpp"
+#include "Renderer.hpp"
+#include "MouseLook.hpp"
+#include "Profiler.hpp"
+#include "TraceCapture.hpp"
+#include "InputRecording.hpp"
+#include "Checksum.hpp"
 
 #define DEG_TO_RAD(x) (x*M_PI/180.0f)
 
-// extern used by Level.cpp
-Shader * shader = nullptr;
+static Shader * shader = nullptr;
 
 static SDL_Point windowDim = { 1280, 720 };
 static bool running = true;
@@ -50,6 +58,7 @@ static glm::mat4 P;
 static glm::mat4 M;
 static bool captureMouse = false; // TODO rename
 static PostProcess * postprocess(nullptr);
+static Renderer * renderer(nullptr);
 
 static Level * lev_main( nullptr );
 static Level * lev_menu( nullptr );
@@ -63,7 +72,31 @@ static bool aPressed(false);
 static bool sPressed(false);
 static bool dPressed(false);
 static bool spacePressed(false);
+// Space was pressed since the last update
+static bool jumpPressed(false);
 static bool lmbPressed(false);
+static MouseLook mouseLook;
+// MouseLook total the player has already been turned by
+static glm::ivec2 mouseLookUsed( 0, 0 );
+
+static TraceCapture traceCapture;
+
+static InputRecording inputRecording;
+// rand() is seeded with this before loading and again when a game starts, so
+// a recording of the input is enough to play a game again
+static unsigned gameSeed( 0 );
+// Where to record the next game; empty to not record
+static std::string recordFile;
+// Playing a recording instead of reading input
+static bool replaying( false );
+// Replaying as fast as possible and reporting how fast that was
+static bool benchmark( false );
+// Frame times of a benchmark, in milliseconds
+static std::vector<float> benchmarkFrames;
+// Updates between printed checksums while recording or replaying
+const static int CHECKSUM_INTERVAL = 600;
+// Frames recorded by a capture started with F9 or --trace
+static int traceFrames( 300 );
 
 const static glm::vec3 sceneAmbient( 0.f, 0.f, 0.f );
 
@@ -79,6 +112,14 @@ static bool debug_ssaa_amount = 1; // set to 1 to turn off ssaa
 bool use_self_illumination = true;
 bool postprocess_blur = false;
 
+// Gameplay is counted in updates, so they always happen this often no matter
+// how fast frames are drawn
+const static double TIMESTEP = 1.0 / 60.0;
+// Most updates run to catch up in one frame; time past this is dropped
+const static int MAX_UPDATES_PER_FRAME = 5;
+// Field of view for culling, in degrees; wider than drawn for late latching
+const static double CULL_FOV = 100.0;
+
 static int spawn_timer = 0;
 const static int spawn_cooldown = 120;
 
@@ -94,6 +135,8 @@ bool global_cheats( false );
 static bool fullscreen( false );
 static bool show_options( false );
 static bool show_fps( false );
+static bool show_profiler( false );
+static bool show_render_stats( false );
 static bool show_quit_confirm( false );
 
 int warning_timer = 0;
@@ -140,15 +183,194 @@ setFPSMode( bool fpsmode )
 {
     captureMouse = fpsmode;
 
-    if ( fpsmode ) {
-        /* If we don't move the mouse to the center then next timestep it will
-         * take the cursors postion inside the menu (not at the center), use it
-         * to calculate the mouse movement, and send the view flying off in some
-         * weird direction. */
-        SDL_WarpMouseInWindow( window, windowDim.x/2, windowDim.y/2 );
-        SDL_ShowCursor(0); // TODO doesn't work on Ubuntu
-    } else {
-        SDL_ShowCursor(1); // TODO doesn't work on Ubuntu
+    // Relative mode hides the cursor and reports movement even at the edge
+    // of the window, so there's no need to keep warping it to the center
+    if ( SDL_SetRelativeMouseMode( fpsmode ? SDL_TRUE : SDL_FALSE ) != 0 ) {
+        printf( "Relative mouse mode not supported: %s\n", SDL_GetError() );
+    }
+
+    // Movement from while we weren't looking around doesn't count
+    mouseLookUsed = mouseLook.getTotal();
+}
+
+/** @brief Count what the current level holds. */
+static SceneStats
+getSceneStats( void )
+{
+    SceneStats stats = SceneStats();
+    current_level->getSceneStats( stats );
+    return stats;
+}
+
+static void
+startTrace( void )
+{
+    char filename[64];
+    time_t now = time( NULL );
+    strftime( filename, 64, "trace-%Y%m%d-%H%M%S.json", localtime( &now ) );
+    traceCapture.start( filename, traceFrames );
+}
+
+/** @brief Hand the frame the profiler just closed to a running capture. */
+static void
+recordTrace( void )
+{
+    if ( !traceCapture.isCapturing() ) return;
+
+    FrameTimings timings = renderer->getFramePacer().getLastTimings();
+    traceCapture.addCounter( "Frame timings (ms)", "frame", timings.frame );
+    traceCapture.addCounter( "Frame timings (ms)", "cpu", timings.cpu );
+    traceCapture.addCounter( "Frame timings (ms)", "gpu wait", timings.gpuWait );
+    traceCapture.addCounter( "Frame timings (ms)", "render", timings.render );
+    traceCapture.addCounter( "Frame timings (ms)", "present", timings.present );
+    traceCapture.addCounter( "GPU passes (ms)", "scene", timings.gpuScene );
+    traceCapture.addCounter( "GPU passes (ms)", "post process", timings.gpuPostProcess );
+    traceCapture.addCounter( "GPU passes (ms)", "gui", timings.gpuGui );
+
+    RenderStats render = renderer->getLastStats();
+    traceCapture.addCounter( "Draw calls", "draw calls", render.drawCalls );
+    traceCapture.addCounter( "Triangles", "triangles", render.triangles );
+    traceCapture.addCounter( "State changes", "program binds", render.programBinds );
+    traceCapture.addCounter( "State changes", "VAO binds", render.vaoBinds );
+    traceCapture.addCounter( "State changes", "texture binds", render.textureBinds );
+    traceCapture.addCounter( "Uniform uploads", "uniform uploads", render.uniformUploads );
+
+    SceneStats scene = getSceneStats();
+    traceCapture.addCounter( "Scene", "entities", scene.entities );
+    traceCapture.addCounter( "Scene", "animated scenery", scene.animatedGeometry );
+    traceCapture.addCounter( "Components", "transforms", scene.transforms );
+    traceCapture.addCounter( "Components", "velocities", scene.velocities );
+    traceCapture.addCounter( "Components", "lifetimes", scene.lifetimes );
+    traceCapture.addCounter( "Components", "healths", scene.healths );
+    traceCapture.addCounter( "Components", "meshes", scene.meshes );
+    traceCapture.addCounter( "Components", "colliders", scene.colliders );
+    traceCapture.addCounter( "Components", "emitters", scene.emitters );
+    traceCapture.addCounter( "Components", "animations", scene.animations );
+    traceCapture.addCounter( "Components", "enemies", scene.enemies );
+
+    traceCapture.addFrame( *Profiler::getInstance() );
+}
+
+/** @brief Leave the main menu and start playing. */
+static void
+startGame( void )
+{
+    srand( gameSeed );
+    switchLevel( lev_main );
+
+    if ( replaying ) {
+        // Playing is up to the recording; leave the real mouse alone
+        captureMouse = true;
+        return;
+    }
+
+    setFPSMode( true );
+    if ( !recordFile.empty() ) inputRecording.startRecording( recordFile, gameSeed );
+}
+
+/**
+ * @brief Get the input for the next update, from the player or a recording.
+ * @remark Records the input if a recording is being made.
+ */
+static TickInput
+readTickInput( void )
+{
+    TickInput input = TickInput();
+    if ( replaying ) {
+        inputRecording.next( input );
+        return input;
+    }
+
+    if ( wPressed ) input.buttons |= INPUT_FORWARD;
+    if ( sPressed ) input.buttons |= INPUT_BACK;
+    if ( aPressed ) input.buttons |= INPUT_LEFT;
+    if ( dPressed ) input.buttons |= INPUT_RIGHT;
+    if ( jumpPressed ) input.buttons |= INPUT_JUMP;
+    if ( lmbPressed ) input.buttons |= INPUT_FIRE;
+    if ( captureMouse ) input.buttons |= INPUT_CAPTURE;
+    if ( global_cheats ) input.buttons |= INPUT_CHEATS;
+    jumpPressed = false;
+
+    // If a frame runs several updates the first one gets all of the movement
+    if ( captureMouse && !isOnMainMenu() ) {
+        glm::ivec2 lookTotal = mouseLook.getTotal();
+        // clamped to what a recording can hold, so live and replayed match
+        input.look = glm::clamp( lookTotal - mouseLookUsed, glm::ivec2( -32768 ), glm::ivec2( 32767 ) );
+        mouseLookUsed = lookTotal;
+    }
+
+    inputRecording.record( input );
+    return input;
+}
+
+/** @brief Hash everything a game's outcome depends on. */
+static std::uint64_t
+getChecksum( void )
+{
+    Player * player = Player::getInstance();
+    glm::vec3 location = player->getLocation();
+    glm::vec3 rotation = player->getRotation();
+    double health = player->getHealth();
+
+    std::uint64_t hash = CHECKSUM_START;
+    hash = checksumBytes( hash, &location, sizeof( location ) );
+    hash = checksumBytes( hash, &rotation, sizeof( rotation ) );
+    hash = checksumBytes( hash, &health, sizeof( health ) );
+    hash = checksumBytes( hash, &global_kills, sizeof( global_kills ) );
+    hash = checksumBytes( hash, &global_difficulty, sizeof( global_difficulty ) );
+    hash = checksumBytes( hash, &spawn_timer, sizeof( spawn_timer ) );
+    return lev_main->getChecksum( hash );
+}
+
+/** @brief Print how long benchmark frames took. */
+static void
+reportBenchmark( void )
+{
+    std::vector<float> & frames = benchmarkFrames;
+    if ( frames.empty() ) {
+        printf( "Benchmark: no frames\n" );
+        return;
+    }
+
+    std::sort( frames.begin(), frames.end() );
+    double sum = 0.0;
+    for ( float ms : frames ) {
+        sum += ms;
+    }
+    int n = frames.size();
+
+    printf( "Benchmark: %d frames, mean %.3f ms\n", n, sum / n );
+    printf( "  p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+            frames[n * 50 / 100], frames[n * 90 / 100], frames[n * 99 / 100], frames[n - 1] );
+}
+
+/**
+ * @brief Checksum a recorded or replayed update and end the recording or
+ *        replay with the game.
+ */
+static void
+checkTick( void )
+{
+    std::uint64_t checksum = getChecksum();
+    int tick = inputRecording.getTick();
+    if ( tick % CHECKSUM_INTERVAL == 0 ) {
+        printf( "Update %d: checksum %016llx\n", tick, (unsigned long long)checksum );
+    }
+
+    bool over = isOnMainMenu() || ( replaying && !inputRecording.isReplaying() );
+    if ( !over ) return;
+
+    printf( "Finished after %d updates: checksum %016llx\n", tick, (unsigned long long)checksum );
+    inputRecording.stopRecording();
+    if ( replaying ) {
+        replaying = false;
+        if ( benchmark ) {
+            reportBenchmark();
+            running = false;
+        } else {
+            // hand the game over to the player, paused
+            setFPSMode( false );
+        }
     }
 }
 
@@ -270,7 +492,6 @@ init_psys_config( void )
 
     psys_conf_bullet.model = cache_model->getAnimation( "bullet" );
     psys_conf_bullet.material = cache_texture->getMaterial( "bullet" );
-    psys_conf_bullet.shader = shader;
     psys_conf_bullet.number[PSYS_MEAN] = 20.0;
     psys_conf_bullet.number[PSYS_VAR] = 1.0;
     psys_conf_bullet.life[PSYS_MEAN] = 15;
@@ -283,7 +504,6 @@ init_psys_config( void )
 
     psys_conf_bullet_trail.model = cache_model->getAnimation( "bullet" );
     psys_conf_bullet_trail.material = cache_texture->getMaterial( "bullet" );
-    psys_conf_bullet_trail.shader = shader;
     psys_conf_bullet_trail.number[PSYS_MEAN] = 0.3;
     psys_conf_bullet_trail.number[PSYS_VAR] = 0.5;
     psys_conf_bullet_trail.life[PSYS_MEAN] = 15;
@@ -299,7 +519,6 @@ init_psys_config( void )
     ParticleSystemConfig spawner;
     spawner.model = cache_model->getAnimation( "bullet" );
     spawner.material = cache_texture->getMaterial( "spawner_particle" );
-    spawner.shader = shader;
     spawner.number[PSYS_MEAN] = 5;
     spawner.number[PSYS_VAR] = 1;
     spawner.life[PSYS_MEAN] = 60;
@@ -317,6 +536,8 @@ static void
 init( void )
 {
     // create the player instance before we need it
+    PROFILE_SCOPE( "Load assets" );
+
     Player * player = Player::getInstance();
 
     shader = new Shader( "Assets/PhongVertex.glsl", "Assets/PhongFragment.glsl" );
@@ -380,9 +601,7 @@ windowResized( SDL_WindowEvent & evt )
     windowDim.y = evt.data2;
     P = glm::perspective( 45.0, windowDim.x / (double)windowDim.y, 0.1, 100.0 );
 
-    // Since frame buffer targets are resolution dependent we must update them.
-    if ( postprocess ) postprocess->changeResolution( windowDim );
-
+    // The renderer resizes the post process targets when it sees the new size
 }
 
 static void
@@ -398,8 +617,6 @@ windowEvent( SDL_WindowEvent & evt )
 static void
 keydown( SDL_KeyboardEvent & evt )
 {
-    Player * player;
-
     switch (evt.keysym.sym) {
         case SDLK_w:
             wPressed = true;
@@ -415,15 +632,14 @@ keydown( SDL_KeyboardEvent & evt )
             break;
         case SDLK_SPACE:
             spacePressed = true;
-            player = Player::getInstance();
-            if ( player->canJump() ) {
-                player->jump();
-                SoundCache::getInstance()->playSound( "Assets/Jump5.wav" );
-            }
+            jumpPressed = true;
             break;
         case SDLK_ESCAPE:
             setFPSMode( !captureMouse );
             break;
+        case SDLK_F9:
+            startTrace();
+            break;
     }
 }
 
@@ -487,7 +703,7 @@ guiMainMenu( void )
             ImGui::PopFont();
 
             ImGui::TextWrapped( "The aliens ate all your cake! There's no more meaning to your life." );
-            ImGui::TextWrapped( "You fought valiently (yet futily) for %f seconds.", timesteps_lasted / 60.f );
+            ImGui::TextWrapped( "You fought valiently (yet futily) for %f seconds.", timesteps_lasted * TIMESTEP );
             ImGui::TextWrapped( "Also, you eradicated %d aliens.", global_kills );
 
             size = ImGui::CalcTextSize( "Quit" );
@@ -559,8 +775,7 @@ guiMainMenu( void )
             size = ImGui::CalcTextSize( "Start!" );
             ImGui::SetCursorPosX( (ImGui::GetWindowWidth()-sty.WindowPadding.x) / 2 - size.x / 2 );
             if ( ImGui::Button("Start!") ) {
-                switchLevel( lev_main );
-                setFPSMode( true );
+                startGame();
                 show_story = false;
                 SoundCache::getInstance()->playSound( "Assets/Blip_Select11.wav" );
             }
@@ -571,7 +786,9 @@ guiMainMenu( void )
 static void
 guiLogic( void )
 {
-    ImGui_ImplSdlGL3_NewFrame();
+    PROFILE_SCOPE( "guiLogic" );
+
+    renderer->beginGuiFrame();
 
 
     if ( isOnMainMenu() ) {
@@ -623,8 +840,31 @@ guiLogic( void )
         ImGui::Checkbox( "Debug normals", &debug_show_normals );
         ImGui::Checkbox( "Use lights", &debug_use_lights );
         ImGui::Checkbox( "Show FPS", &show_fps );
+        if ( ImGui::Checkbox( "Show profiler", &show_profiler ) ) {
+            Profiler::getInstance()->setEnabled( show_profiler );
+        }
+        ImGui::Checkbox( "Show render stats", &show_render_stats );
+        if ( traceCapture.isCapturing() ) {
+            ImGui::Text( "Capturing trace..." );
+        } else if ( ImGui::Button( "Capture trace (F9)" ) ) {
+            startTrace();
+        }
         ImGui::Checkbox( "Use cheats", &global_cheats );
         ImGui::Checkbox( "Use self illumination", &use_self_illumination );
+
+        FramePacer & pacer = renderer->getFramePacer();
+        bool vsync = pacer.getSwapInterval() != 0;
+        if ( ImGui::Checkbox( "Vsync", &vsync ) ) {
+            pacer.setSwapInterval( vsync ? 1 : 0 );
+        }
+        int frameLimit = pacer.getFrameLimit();
+        if ( ImGui::SliderInt( "Frame limit (0 = off)", &frameLimit, 0, 300 ) ) {
+            pacer.setFrameLimit( frameLimit );
+        }
+        int framesInFlight = pacer.getMaxFramesInFlight();
+        if ( ImGui::SliderInt( "Frames in flight", &framesInFlight, 1, 3 ) ) {
+            pacer.setMaxFramesInFlight( framesInFlight );
+        }
         ImGui::End();
     }
 
@@ -640,6 +880,51 @@ guiLogic( void )
         ImGui::SetNextWindowPos( ImVec2(0, 0), ImGuiSetCond_Always );
         ImGui::Begin("FPS", NULL, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove );
         ImGui::Text("FPS: %f", ImGui::GetIO().Framerate);
+
+        FrameTimings average = renderer->getFramePacer().getAverageTimings();
+        ImGui::Text("Frame: %.2f ms", average.frame);
+        ImGui::Text("CPU: %.2f ms", average.cpu);
+        ImGui::Text("GPU wait: %.2f ms", average.gpuWait);
+        ImGui::Text("Render: %.2f ms", average.render);
+        ImGui::Text("Present: %.2f ms", average.present);
+        ImGui::Text("GPU scene: %.2f ms", average.gpuScene);
+        ImGui::Text("GPU post process: %.2f ms", average.gpuPostProcess);
+        ImGui::Text("GPU gui: %.2f ms", average.gpuGui);
+        ImGui::End();
+    }
+
+    if ( show_profiler ) {
+        Profiler::getInstance()->drawWindow( &show_profiler );
+    }
+
+    if ( show_render_stats ) {
+        RenderStats render = renderer->getLastStats();
+        SceneStats scene = getSceneStats();
+
+        ImGui::Begin( "Render stats", &show_render_stats, ImGuiWindowFlags_AlwaysAutoResize );
+        ImGui::Text( "Draw calls: %d", render.drawCalls );
+        ImGui::Text( "Vertices: %d", render.vertices );
+        ImGui::Text( "Triangles: %d", render.triangles );
+        ImGui::Text( "Program binds: %d", render.programBinds );
+        ImGui::Text( "VAO binds: %d", render.vaoBinds );
+        ImGui::Text( "Texture binds: %d", render.textureBinds );
+        ImGui::Text( "Uniform uploads: %d", render.uniformUploads );
+        ImGui::Separator();
+        ImGui::Text( "Threads: %d, rendering on %s", JobSystem::getInstance()->getThreadCount(), renderer->isThreaded() ? "its own" : "the main one" );
+        ImGui::Text( "Scenery: %d (%d animated)", scene.staticGeometry, scene.animatedGeometry );
+        ImGui::Text( "Static collision: %d boxes, merged from %d", scene.staticBoxes, scene.unmergedStaticBoxes );
+        ImGui::Text( "Flow field: %dx%d cells, %d blocked", scene.flowFieldWidth, scene.flowFieldDepth, scene.blockedFlowCells );
+        ImGui::Text( "Entities: %d", scene.entities );
+        ImGui::Separator();
+        ImGui::Text( "Transforms: %d", scene.transforms );
+        ImGui::Text( "Velocities: %d", scene.velocities );
+        ImGui::Text( "Lifetimes: %d", scene.lifetimes );
+        ImGui::Text( "Healths: %d", scene.healths );
+        ImGui::Text( "Meshes: %d", scene.meshes );
+        ImGui::Text( "Colliders: %d", scene.colliders );
+        ImGui::Text( "Emitters: %d", scene.emitters );
+        ImGui::Text( "Animations: %d", scene.animations );
+        ImGui::Text( "Enemies: %d", scene.enemies );
         ImGui::End();
     }
 }
@@ -658,6 +943,8 @@ getRandomEnemyTexture()
 static void
 update_spawner( void )
 {
+    PROFILE_SCOPE( "update_spawner" );
+
     TextureCache * cache_texture = TextureCache::getInstance();
     ModelCache * cache_model = ModelCache::getInstance();
 
@@ -666,18 +953,15 @@ update_spawner( void )
     if ( spawn_timer <= 0 ) {
         spawn_timer = spawn_cooldown - global_difficulty/2;
 
-        Enemy * enemy = new Enemy( cache_model->getAnimation("spike_living"), getRandomEnemyTexture(), shader, current_level );
-        current_level->addEnemy( enemy );
-
+        Material * enemyMaterial = getRandomEnemyTexture();
         float deg = glm::radians( (float)(rand() % 360) );
         glm::mat4 R = glm::rotate( deg, glm::vec3(0.f, 1.f, 0.f) );
         glm::vec4 spawnLocation = R * glm::vec4(19.f, -3.f, 0.f, 1.f);
-        enemy->translate( glm::vec3( spawnLocation ) );
+        current_level->addEnemy( cache_model->getAnimation("spike_living"), enemyMaterial, glm::vec3( spawnLocation ) );
 
         ParticleSystemConfig psysconf = ParticleSystem::getConfiguration( "spawner" );
         psysconf.position[PSYS_MEAN] =  glm::vec3( spawnLocation );
-        ParticleSystem * parts = new ParticleSystem( psysconf, 60 );
-        current_level->addParticleSystem( parts );
+        ParticleSystem::create( current_level->getWorld(), psysconf, 60 );
 
         SoundCache::getInstance()->playSound( "Assets/Randomize9.wav" );
     }
@@ -685,14 +969,13 @@ update_spawner( void )
 }
 
 static void
-apply_gravity( void )
+update_player_physics( const glm::vec3 & walk )
 {
-    if ( !debug_use_gravity ) return;
     if ( isOnMainMenu() ) return;
 
     Player * player = Player::getInstance();
     bool beforeCanJump = player->canJump();
-    player->updateGravity( current_level );
+    player->move( walk, current_level, debug_use_gravity );
     bool afterCanJump = player->canJump();
 
     if ( beforeCanJump != afterCanJump && afterCanJump ) {
@@ -701,7 +984,7 @@ apply_gravity( void )
 }
 
 static void
-update( void )
+processEvents( void )
 {
     SDL_Event evt;
     while (SDL_PollEvent( &evt ) ) {
@@ -726,43 +1009,57 @@ update( void )
             case SDL_MOUSEBUTTONUP:
                 mouseup( evt.button );
                 break;
+            case SDL_MOUSEMOTION:
+                if ( captureMouse ) mouseLook.addMotion( evt.motion.xrel, evt.motion.yrel );
+                break;
         }
     }
+}
 
-    update_spawner();
+static void
+update( void )
+{
+    PROFILE_SCOPE( "update" );
 
-    apply_gravity();
+    TickInput input = readTickInput();
+    if ( replaying ) {
+        captureMouse = ( input.buttons & INPUT_CAPTURE ) != 0;
+        global_cheats = ( input.buttons & INPUT_CHEATS ) != 0;
+    }
 
-    Player * player = Player::getInstance();
+    update_spawner();
 
-    if ( captureMouse ) {
-        if ( !isOnMainMenu() ) {
-            int mouseX, mouseY;
-            SDL_GetMouseState( &mouseX, &mouseY );
+    Player * player = Player::getInstance();
+    player->savePreviousState();
 
-            int dx = mouseX - windowDim.x/2;
-            int dy = mouseY - windowDim.y/2;
+    if ( ( input.buttons & INPUT_JUMP ) && player->canJump() ) {
+        player->jump();
+        SoundCache::getInstance()->playSound( "Assets/Jump5.wav" );
+    }
 
-            player->rotate( glm::vec3(dy/100.0, dx/100.0, 0.0) );
+    // Walking and falling are collided together once input has been read
+    glm::vec3 walk( 0.0, 0.0, 0.0 );
 
-            SDL_WarpMouseInWindow( window, windowDim.x/2, windowDim.y/2 );
+    if ( captureMouse ) {
+        if ( !isOnMainMenu() ) {
+            player->rotate( MouseLook::toRotation( input.look ) );
 
             glm::vec3 moveVec(0.0, 0.0, 0.0);
             bool tryingToMove( false );
 
-            if ( wPressed ) {
+            if ( input.buttons & INPUT_FORWARD ) {
                 moveVec += glm::vec3(0, 0, -1.0);
                 tryingToMove = true;
             }
-            if ( sPressed ) {
+            if ( input.buttons & INPUT_BACK ) {
                 moveVec += glm::vec3(0, 0, 1.0);
                 tryingToMove = true;
             }
-            if ( aPressed ) {
+            if ( input.buttons & INPUT_LEFT ) {
                 moveVec += glm::vec3(-1.0, 0, 0);
                 tryingToMove = true;
             }
-            if ( dPressed ) {
+            if ( input.buttons & INPUT_RIGHT ) {
                 moveVec += glm::vec3(1.0, 0, 0);
                 tryingToMove = true;
             }
@@ -772,15 +1069,14 @@ update( void )
             if ( tryingToMove && !(moveVec.x == 0.0 && moveVec.y == 0.0 && moveVec.z == 0.0) ) {
                 moveVec = glm::normalize(moveVec);
                 moveVec = 0.1f * moveVec;
-                player->tryToMove( glm::vec3(moveVec.x, 0, moveVec.z), current_level );
+                walk = glm::vec3( moveVec.x, 0, moveVec.z );
             }
 
-            if ( lmbPressed && player->canShoot() ) {
+            if ( ( input.buttons & INPUT_FIRE ) && player->canShoot() ) {
                 TextureCache * cache_texture = TextureCache::getInstance();
                 ModelCache * cache_model = ModelCache::getInstance();
                 player->shoot();
-                Bullet * b = new Bullet( cache_model->getAnimation( "bullet" ), cache_texture->getMaterial( "bullet" ), shader, player->getLocation(), player->getViewVector() );
-                current_level->addBullet( b );
+                Bullet::create( current_level->getWorld(), cache_model->getAnimation( "bullet" ), cache_texture->getMaterial( "bullet" ), player->getLocation(), player->getViewVector() );
                 SoundCache::getInstance()->playSound( "Assets/Explosion3.wav" );
             }
 
@@ -788,8 +1084,11 @@ update( void )
         }
     }
 
+    update_player_physics( walk );
+
     player->updateShootCooldown();
 
+    current_level->setViewProjection( P * player->getViewMatrix() );
     current_level->update();
 
     if ( warning_timer > 0 ) warning_timer--;
@@ -805,6 +1104,8 @@ update( void )
     }
     // TODO broken!
     if ( debug_light_follow_player ) current_level->lightFollowPlayer();
+
+    if ( inputRecording.isRecording() || replaying ) checkTick();
 }
 
 /*******************************************************************************
@@ -812,77 +1113,47 @@ update( void )
 *******************************************************************************/
 
 static void
-updateMatrixUniforms( void )
-{
-    GLuint location;
-
-    Player * player = Player::getInstance();
-    glm::mat4 V = player->getViewMatrix();
-    location = shader->getUniformLocation("V");
-    glUniformMatrix4fv( location, 1, GL_FALSE, &V[0][0] );
-
-    location = shader->getUniformLocation("P");
-    glUniformMatrix4fv( location, 1, GL_FALSE, &P[0][0] );
-}
-
-static void
-updateGFXOptionsUniforms( void )
+render( float interpolation )
 {
-    GLuint location;
+    PROFILE_SCOPE( "render" );
 
-    location = shader->getUniformLocation("use_normal_mapping");
-    glUniform1i(location, use_normal_mapping);
-    location = shader->getUniformLocation("use_specular_mapping");
-    glUniform1i(location, use_specular_mapping);
-    location = shader->getUniformLocation("use_texture_mapping");
-    glUniform1i(location, use_texture_mapping);
-    location = shader->getUniformLocation("debug_show_normals");
-    glUniform1i(location, debug_show_normals);
-    location = shader->getUniformLocation("debug_use_lights");
-    glUniform1i(location, debug_use_lights);
-    location = shader->getUniformLocation("use_self_illumination");
-    glUniform1i(location, use_self_illumination);
-}
+    RenderSnapshot & frame = renderer->getSnapshot();
+    frame.clear();
 
-static void
-render( void )
-{
-    GLuint location;
-
-    // TODO do we need to call these every timestep?
-    glClearColor( 0.1, 0.1, 0.1, 1.0 );
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_CULL_FACE);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    // step 1: draw to framebuffer
-    postprocess->enable();
-    shader->enable();
-        updateMatrixUniforms();
-        Material::updateTextureUniforms( shader );
-        updateGFXOptionsUniforms();
-
-        location = shader->getUniformLocation("k_a");
-        glUniform3f(location, sceneAmbient.x, sceneAmbient.y, sceneAmbient.z);
-
-        // Draw the entire scene
-        current_level->draw( shader );
-    shader->disable();
-    postprocess->disable();
-
-    // step 2: draw this to the screen
-    glViewport(0, 0, windowDim.x, windowDim.y);
-    glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
-
-    postprocess->render();
-
-    // step 3: draw gui (made in guiLogic)
-    // we do this last to not interfere with post process
+    Player * player = Player::getInstance();
+    frame.V = player->getViewMatrix( interpolation );
+    frame.camera.location = player->getLocation( interpolation );
+    frame.camera.rotation = player->getRotation();
+    frame.camera.lookTotal = mouseLookUsed;
+    frame.camera.lateLatch = captureMouse && !isOnMainMenu() && !replaying;
+    frame.P = P;
+    frame.windowDim = windowDim;
+    frame.ambient = sceneAmbient;
+
+    frame.settings.normalMapping = use_normal_mapping;
+    frame.settings.specularMapping = use_specular_mapping;
+    frame.settings.textureMapping = use_texture_mapping;
+    frame.settings.selfIllumination = use_self_illumination;
+    frame.settings.showNormals = debug_show_normals;
+    frame.settings.useLights = debug_use_lights;
+    frame.settings.blur = postprocess_blur;
+
+    // Gather the entire scene. The renderer may turn the camera a little
+    // further by newer mouse movement, so cull to a wider view than drawn.
+    glm::mat4 cullP = glm::perspective( glm::radians( CULL_FOV ), windowDim.x / (double)windowDim.y, 0.1, 100.0 );
+    current_level->setViewProjection( cullP * frame.V );
+    current_level->draw( frame, interpolation );
+
+    // gui (made in guiLogic) is copied since ImGui reuses its lists next frame
     ImGui::Render();
+    frame.gui.copy( ImGui::GetDrawData() );
 
-    SDL_GL_SwapWindow( window );
-    CHECK_GL_ERRORS;
+    FramePacer & pacer = renderer->getFramePacer();
+    frame.timings = FrameTimings();
+    frame.timings.cpu = pacer.getCpuTime();
+    frame.timings.frame = pacer.getLastFrameTime();
+
+    renderer->submit();
 }
 
 /*******************************************************************************
@@ -892,6 +1163,13 @@ render( void )
 void
 cleanup( void )
 {
+    if ( inputRecording.isRecording() ) {
+        printf( "Quit after %d updates: checksum %016llx\n", inputRecording.getTick(), (unsigned long long)getChecksum() );
+        inputRecording.stopRecording();
+    }
+
+    // gives the OpenGL context back to this thread
+    delete renderer;
     delete postprocess;
 
     Mix_FreeMusic( testMusic );
@@ -902,8 +1180,11 @@ cleanup( void )
     ModelCache::cleanup();
 
     delete lev_main; // deletes entire tree
+    delete lev_menu;
 
     Player::cleanup();
+    JobSystem::cleanup();
+    Profiler::cleanup();
 }
 
 /*******************************************************************************
@@ -962,16 +1243,112 @@ main( int argc,
         throw Exception( "Failed to initialize dear imgui" );
     }
 
-    srand( time(NULL) );
+    bool threadedRendering = true;
+    int swapInterval = 1;
+    int frameLimit = 0;
+    int framesInFlight = 2;
+    const char * traceFile = nullptr;
+    const char * replayFile = nullptr;
+    for ( int i = 1; i < argc; i++ ) {
+        if ( strcmp( argv[i], "--no-render-thread" ) == 0 ) {
+            threadedRendering = false;
+        } else if ( strcmp( argv[i], "--vsync" ) == 0 && i + 1 < argc ) {
+            swapInterval = atoi( argv[++i] );
+        } else if ( strcmp( argv[i], "--fps" ) == 0 && i + 1 < argc ) {
+            frameLimit = atoi( argv[++i] );
+        } else if ( strcmp( argv[i], "--frames-in-flight" ) == 0 && i + 1 < argc ) {
+            framesInFlight = atoi( argv[++i] );
+        } else if ( strcmp( argv[i], "--trace" ) == 0 && i + 1 < argc ) {
+            traceFile = argv[++i];
+        } else if ( strcmp( argv[i], "--trace-frames" ) == 0 && i + 1 < argc ) {
+            traceFrames = atoi( argv[++i] );
+        } else if ( strcmp( argv[i], "--record" ) == 0 && i + 1 < argc ) {
+            recordFile = argv[++i];
+        } else if ( strcmp( argv[i], "--replay" ) == 0 && i + 1 < argc ) {
+            replayFile = argv[++i];
+        } else if ( strcmp( argv[i], "--benchmark" ) == 0 ) {
+            benchmark = true;
+        } else if ( strcmp( argv[i], "--profile" ) == 0 ) {
+            // on from the start so loading is timed too
+            show_profiler = true;
+        }
+    }
+
+    Profiler * profiler = Profiler::getInstance();
+    profiler->setThreadName( "Main" );
+    profiler->setEnabled( show_profiler );
+    if ( traceFile ) traceCapture.start( traceFile, traceFrames );
+
+    gameSeed = time(NULL);
+    if ( replayFile ) {
+        if ( !inputRecording.load( replayFile ) ) {
+            throw Exception( "Failed to load the replay" );
+        }
+        gameSeed = inputRecording.getSeed();
+        replaying = true;
+    }
+    benchmark = benchmark && replaying;
+    if ( benchmark ) {
+        // as fast as frames can go
+        swapInterval = 0;
+        frameLimit = 0;
+    }
+
+    srand( gameSeed );
 
     init();
+    if ( replaying ) startGame();
+
+    // Everything that touches OpenGL outside the renderer happens before here
+    ImGui_ImplSdlGL3_CreateDeviceObjects();
+    renderer = new Renderer( window, context, shader, postprocess, threadedRendering );
+    renderer->setMouseLook( &mouseLook );
+
+    FramePacer & pacer = renderer->getFramePacer();
+    pacer.setSwapInterval( swapInterval );
+    pacer.setFrameLimit( frameLimit );
+    pacer.setMaxFramesInFlight( framesInFlight );
+
+    Uint64 lastTime = SDL_GetPerformanceCounter();
+    double accumulator = 0.0;
 
     while (running) {
+        pacer.beginFrame();
+        profiler->beginFrame();
+        recordTrace();
+
+        Uint64 now = SDL_GetPerformanceCounter();
+        accumulator += ( now - lastTime ) / (double)SDL_GetPerformanceFrequency();
+        lastTime = now;
+
+        // After a long stall (loading, dragging the window) skip ahead rather
+        // than fast forwarding through it
+        if ( accumulator > MAX_UPDATES_PER_FRAME * TIMESTEP ) {
+            accumulator = MAX_UPDATES_PER_FRAME * TIMESTEP;
+        }
+
+        {
+            PROFILE_SCOPE( "processEvents" );
+            processEvents();
+        }
         guiLogic();
-        update();
-        render();
 
-        SDL_Delay(1);
+        if ( benchmark && replaying ) {
+            // One update a frame however long frames take, so every build
+            // does the same work per frame
+            if ( inputRecording.getTick() > 0 ) benchmarkFrames.push_back( pacer.getLastFrameTime() );
+            update();
+            render( 1.f );
+            continue;
+        }
+
+        while ( accumulator >= TIMESTEP && running ) {
+            update();
+            accumulator -= TIMESTEP;
+        }
+
+        // Draw between the last two updates by how far we are into the next
+        render( accumulator / TIMESTEP );
     }
 
     // TODO proper cleanup